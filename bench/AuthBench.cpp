@@ -0,0 +1,44 @@
+// 认证基准：各 Argon2 档位下的注册与登录延迟（内存库，排除磁盘因素）
+#include "Bench.h"
+#include "UserAuth.h"
+#include <stdexcept>
+
+void RunAuthBench(BenchReporter& reporter, const BenchOptions& options)
+{
+    struct Profile {
+        const char* name;
+        KdfPolicy policy;
+        int iterations;
+    };
+    const Profile profiles[] = {
+        {"interactive", KdfPolicy::Interactive(), options.quick ? 2 : 10},
+        {"moderate", KdfPolicy::Moderate(), options.quick ? 1 : 4},
+        {"sensitive", KdfPolicy::Sensitive(), options.quick ? 1 : 2},
+    };
+
+    for (const Profile& profile : profiles) {
+        UserAuth auth(":memory:", StorageProfile(), profile.policy);
+        const std::string password = "BenchPassw0rd";
+
+        double register_ns = MeasureNs([&] {
+            for (int i = 0; i < profile.iterations; ++i) {
+                if (!auth.Register("user" + std::to_string(i), password)) {
+                    throw std::runtime_error("Register failed");
+                }
+            }
+        });
+        reporter.Add({"auth", "register", {{"profile", profile.name}},
+                      static_cast<uint64_t>(profile.iterations), register_ns});
+
+        std::vector<UserAuth::CodebookInfo> codebooks;
+        double login_ns = MeasureNs([&] {
+            for (int i = 0; i < profile.iterations; ++i) {
+                if (!auth.Login("user" + std::to_string(i), password, codebooks)) {
+                    throw std::runtime_error("Login failed");
+                }
+            }
+        });
+        reporter.Add({"auth", "login", {{"profile", profile.name}},
+                      static_cast<uint64_t>(profile.iterations), login_ns});
+    }
+}
\ No newline at end of file
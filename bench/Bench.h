@@ -0,0 +1,48 @@
+#pragma once
+// 基准公共部分：计时、结果收集与 JSON 输出。
+// 各套件只负责测量，结果统一交给 BenchReporter，stdout 输出一份 JSON 便于跟踪回归
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct BenchOptions {
+    bool quick = false;                                  // 缩短迭代，用于冒烟
+    std::vector<int> vault_rows = {1000, 100000, 1000000};
+    std::vector<std::string> suites;                     // 为空表示全部
+};
+
+struct BenchResult {
+    std::string suite;
+    std::string name;
+    std::vector<std::pair<std::string, std::string>> params;
+    uint64_t iterations = 0;
+    double total_ns = 0;
+    uint64_t bytes_per_op = 0;   // 非零时额外输出吞吐量
+};
+
+class BenchReporter {
+public:
+    // 同时向 stderr 打印一行可读结果
+    void Add(BenchResult result);
+    void WriteJson(std::FILE* out) const;
+
+private:
+    std::vector<BenchResult> results_;
+};
+
+template <typename F>
+double MeasureNs(F&& body)
+{
+    auto start = std::chrono::steady_clock::now();
+    body();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+void RunAuthBench(BenchReporter& reporter, const BenchOptions& options);
+void RunCryptoBench(BenchReporter& reporter, const BenchOptions& options);
+void RunVaultBench(BenchReporter& reporter, const BenchOptions& options);
+void RunGeneratorBench(BenchReporter& reporter, const BenchOptions& options);
\ No newline at end of file
@@ -0,0 +1,97 @@
+// 基准入口：mypasswd_bench [--quick] [--suite=auth,crypto,vault,generator] [--rows=1000,100000] [--output=file]
+// JSON 结果写到 stdout（或 --output 指定的文件），可读摘要写到 stderr
+#include "Bench.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <sodium.h>
+
+namespace {
+
+std::vector<std::string> SplitList(const char* text)
+{
+    std::vector<std::string> items;
+    std::string current;
+    for (const char* p = text; ; ++p) {
+        if (*p == ',' || *p == '\0') {
+            if (!current.empty()) {
+                items.push_back(current);
+            }
+            current.clear();
+            if (*p == '\0') {
+                break;
+            }
+        } else {
+            current += *p;
+        }
+    }
+    return items;
+}
+
+bool Wanted(const BenchOptions& options, const char* suite)
+{
+    return options.suites.empty() ||
+           std::find(options.suites.begin(), options.suites.end(), suite) != options.suites.end();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    BenchOptions options;
+    const char* output = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (std::strcmp(arg, "--quick") == 0) {
+            options.quick = true;
+        } else if (std::strncmp(arg, "--suite=", 8) == 0) {
+            options.suites = SplitList(arg + 8);
+        } else if (std::strncmp(arg, "--rows=", 7) == 0) {
+            options.vault_rows.clear();
+            for (const std::string& rows : SplitList(arg + 7)) {
+                options.vault_rows.push_back(std::atoi(rows.c_str()));
+            }
+        } else if (std::strncmp(arg, "--output=", 9) == 0) {
+            output = arg + 9;
+        } else {
+            std::fprintf(stderr, "usage: %s [--quick] [--suite=auth,crypto,vault,generator] "
+                                 "[--rows=N,...] [--output=file]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (sodium_init() < 0) {
+        std::fprintf(stderr, "libsodium initialization failed\n");
+        return 1;
+    }
+
+    BenchReporter reporter;
+    try {
+        if (Wanted(options, "auth")) {
+            RunAuthBench(reporter, options);
+        }
+        if (Wanted(options, "crypto")) {
+            RunCryptoBench(reporter, options);
+        }
+        if (Wanted(options, "vault")) {
+            RunVaultBench(reporter, options);
+        }
+        if (Wanted(options, "generator")) {
+            RunGeneratorBench(reporter, options);
+        }
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "benchmark failed: %s\n", e.what());
+        return 1;
+    }
+
+    std::FILE* out = output ? std::fopen(output, "w") : stdout;
+    if (!out) {
+        std::fprintf(stderr, "cannot open %s\n", output);
+        return 1;
+    }
+    reporter.WriteJson(out);
+    if (out != stdout) {
+        std::fclose(out);
+    }
+    return 0;
+}
\ No newline at end of file
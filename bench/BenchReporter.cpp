@@ -0,0 +1,81 @@
+#include "Bench.h"
+
+#include <ctime>
+#include <thread>
+
+namespace {
+
+std::string Escape(const std::string& text)
+{
+    std::string out;
+    out.reserve(text.size());
+    for (char c : text) {
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char buf[8];
+                std::snprintf(buf, sizeof buf, "\\u%04x", c);
+                out += buf;
+            } else {
+                out += c;
+            }
+        }
+    }
+    return out;
+}
+
+double NsPerOp(const BenchResult& result)
+{
+    return result.iterations ? result.total_ns / static_cast<double>(result.iterations) : 0.0;
+}
+
+} // namespace
+
+void BenchReporter::Add(BenchResult result)
+{
+    std::string params;
+    for (const auto& param : result.params) {
+        params += " " + param.first + "=" + param.second;
+    }
+    double ns = NsPerOp(result);
+    std::fprintf(stderr, "%-10s %-28s%-28s %14.1f ns/op", result.suite.c_str(), result.name.c_str(),
+                 params.c_str(), ns);
+    if (result.bytes_per_op && ns > 0) {
+        std::fprintf(stderr, " %10.1f MB/s", static_cast<double>(result.bytes_per_op) * 1e3 / ns);
+    }
+    std::fprintf(stderr, "\n");
+    results_.push_back(std::move(result));
+}
+
+void BenchReporter::WriteJson(std::FILE* out) const
+{
+    char timestamp[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(timestamp, sizeof timestamp, "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+    std::fprintf(out, "{\n  \"schema\": 1,\n  \"timestamp\": \"%s\",\n", timestamp);
+    std::fprintf(out, "  \"hardware_concurrency\": %u,\n", std::thread::hardware_concurrency());
+    std::fprintf(out, "  \"results\": [");
+    for (size_t i = 0; i < results_.size(); ++i) {
+        const BenchResult& result = results_[i];
+        double ns = NsPerOp(result);
+        std::fprintf(out, "%s\n    {\"suite\": \"%s\", \"name\": \"%s\", \"params\": {", i ? "," : "",
+                     Escape(result.suite).c_str(), Escape(result.name).c_str());
+        for (size_t p = 0; p < result.params.size(); ++p) {
+            std::fprintf(out, "%s\"%s\": \"%s\"", p ? ", " : "", Escape(result.params[p].first).c_str(),
+                         Escape(result.params[p].second).c_str());
+        }
+        std::fprintf(out, "}, \"iterations\": %llu, \"ns_per_op\": %.1f, \"ops_per_sec\": %.1f",
+                     static_cast<unsigned long long>(result.iterations), ns, ns > 0 ? 1e9 / ns : 0.0);
+        if (result.bytes_per_op) {
+            std::fprintf(out, ", \"bytes_per_op\": %llu, \"mb_per_sec\": %.1f",
+                         static_cast<unsigned long long>(result.bytes_per_op),
+                         ns > 0 ? static_cast<double>(result.bytes_per_op) * 1e3 / ns : 0.0);
+        }
+        std::fprintf(out, "}");
+    }
+    std::fprintf(out, "\n  ]\n}\n");
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+// 生成器基准：逐个 generateBasic、按策略生成，以及批量生成（标量 / 向量内核）的单个密码耗时
+#include "Bench.h"
+#include "PassWordGen.h"
+#include "CharsetKernel.h"
+#include <string>
+
+namespace {
+
+const char* IsaName(CharsetKernelIsa isa)
+{
+    switch (isa) {
+    case CharsetKernelIsa::Scalar: return "scalar";
+    case CharsetKernelIsa::SSE41: return "sse4.1";
+    case CharsetKernelIsa::AVX2: return "avx2";
+    case CharsetKernelIsa::NEON: return "neon";
+    }
+    return "unknown";
+}
+
+} // namespace
+
+void RunGeneratorBench(BenchReporter& reporter, const BenchOptions& options)
+{
+    const size_t length = 16;
+    const size_t single_count = options.quick ? 10000 : 100000;
+    const size_t batch_count = options.quick ? 100000 : 1000000;
+    const std::string length_param = std::to_string(length);
+    PasswordGenerator generator(length);
+    std::string out;
+
+    volatile size_t sink = 0;
+    double single = MeasureNs([&] {
+        for (size_t i = 0; i < single_count; ++i) {
+            sink = sink + generator.generateBasic().size();
+        }
+    });
+    reporter.Add({"generator", "generate_basic", {{"length", length_param}}, single_count, single});
+
+    double policy = MeasureNs([&] {
+        for (size_t i = 0; i < single_count; ++i) {
+            sink = sink + generator.generate<PasswordPolicy::Extended()>().size();
+        }
+    });
+    reporter.Add({"generator", "generate_policy_extended", {{"length", length_param}}, single_count, policy});
+
+    const CharsetKernelIsa detected = ActiveCharsetKernel();
+    const CharsetKernelIsa candidates[] = {
+        CharsetKernelIsa::Scalar, CharsetKernelIsa::SSE41, CharsetKernelIsa::AVX2, CharsetKernelIsa::NEON,
+    };
+    for (const std::string* charset : {&PasswordGenerator::basicCharset(), &PasswordGenerator::extendedCharset()}) {
+        for (CharsetKernelIsa isa : candidates) {
+            if (!SelectCharsetKernel(isa)) {
+                continue;
+            }
+            double batch = MeasureNs([&] {
+                generator.generateBatch(batch_count, *charset, out);
+            });
+            reporter.Add({"generator", "generate_batch",
+                          {{"length", length_param}, {"charset_size", std::to_string(charset->size())},
+                           {"kernel", IsaName(isa)}},
+                          batch_count, batch});
+        }
+    }
+    SelectCharsetKernel(detected);
+}
\ No newline at end of file
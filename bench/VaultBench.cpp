@@ -0,0 +1,141 @@
+// 密码库基准：在预置 N 行的磁盘库（WAL）上测写入、分页、摘要列表与全文检索
+#include "Bench.h"
+#include "PassWordVault.h"
+#include "UserAuth.h"
+#include "CryptoSession.h"
+#include <sodium.h>
+#include <filesystem>
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+void RemoveDatabase(const std::filesystem::path& path)
+{
+    std::error_code ignored;
+    for (const char* suffix : {"", "-wal", "-shm"}) {
+        std::filesystem::remove(path.string() + suffix, ignored);
+    }
+}
+
+PasswordVault::EntryInput MakeEntry(int i)
+{
+    std::string record(CryptoSession::recordSize(24), '\0');
+    randombytes_buf(record.data(), record.size());
+    return {"host" + std::to_string(i) + ".example.com", std::string(64, 'k'), record,
+            "note " + std::to_string(i % 997) + " shared account", ""};
+}
+
+} // namespace
+
+void RunVaultBench(BenchReporter& reporter, const BenchOptions& options)
+{
+    const int seed_batch = 10000;
+
+    for (int rows : options.vault_rows) {
+        const std::string rows_param = std::to_string(rows);
+        const std::filesystem::path path =
+            std::filesystem::temp_directory_path() / ("mypasswd_bench_" + rows_param + ".db");
+        RemoveDatabase(path);
+
+        {
+            UserAuth auth(path.string(), StorageProfile(), KdfPolicy::Interactive());
+            if (!auth.Register("bench", "BenchPassw0rd")) {
+                throw std::runtime_error("Register failed");
+            }
+            PasswordVault vault(auth.GetDatabase(), auth.GetReadPool());
+            WriteResult codebook = vault.CreateCodebook("bench", "codebook");
+            if (!codebook) {
+                throw std::runtime_error("CreateCodebook failed");
+            }
+            const int codebook_id = static_cast<int>(codebook.id);
+
+            // 预置数据：每批一个事务
+            std::vector<PasswordVault::EntryInput> batch;
+            double seed_ns = MeasureNs([&] {
+                for (int start = 0; start < rows; start += seed_batch) {
+                    batch.clear();
+                    for (int i = start; i < std::min(rows, start + seed_batch); ++i) {
+                        batch.push_back(MakeEntry(i));
+                    }
+                    vault.AddEntries(codebook_id, batch);
+                }
+            });
+            reporter.Add({"vault", "add_entries_batched", {{"rows", rows_param}},
+                          static_cast<uint64_t>(rows), seed_ns});
+
+            const int single = options.quick ? 50 : 1000;
+            double add_ns = MeasureNs([&] {
+                for (int i = 0; i < single; ++i) {
+                    PasswordVault::EntryInput entry = MakeEntry(rows + i);
+                    if (!vault.AddEntry(codebook_id, entry.address, entry.public_key, entry.encrypted_password)) {
+                        throw std::runtime_error("AddEntry failed");
+                    }
+                }
+            });
+            reporter.Add({"vault", "add_entry", {{"rows", rows_param}}, static_cast<uint64_t>(single), add_ns});
+
+            const int reads = options.quick ? 20 : 200;
+            double first_page_ns = MeasureNs([&] {
+                for (int i = 0; i < reads; ++i) {
+                    vault.GetEntries(codebook_id, "", 0, 50);
+                }
+            });
+            reporter.Add({"vault", "get_entries_first_page", {{"rows", rows_param}},
+                          static_cast<uint64_t>(reads), first_page_ns});
+
+            // OFFSET 分页越深越慢，作为游标分页的对照
+            const int deep_page = rows / 2 / 50;
+            const int deep_reads = options.quick ? 3 : 20;
+            double deep_page_ns = MeasureNs([&] {
+                for (int i = 0; i < deep_reads; ++i) {
+                    vault.GetEntries(codebook_id, "", deep_page, 50);
+                }
+            });
+            reporter.Add({"vault", "get_entries_offset_mid", {{"rows", rows_param}},
+                          static_cast<uint64_t>(deep_reads), deep_page_ns});
+
+            std::string cursor;
+            std::string next_cursor;
+            int pages = 0;
+            double keyset_ns = MeasureNs([&] {
+                for (int i = 0; i < reads; ++i) {
+                    vault.GetEntriesAfter(codebook_id, cursor, next_cursor, 50);
+                    cursor = next_cursor;
+                    ++pages;
+                }
+            });
+            reporter.Add({"vault", "get_entries_after", {{"rows", rows_param}},
+                          static_cast<uint64_t>(pages), keyset_ns});
+
+            cursor.clear();
+            double summary_ns = MeasureNs([&] {
+                for (int i = 0; i < reads; ++i) {
+                    vault.ListEntrySummaries(codebook_id, cursor, next_cursor, 50);
+                    cursor = next_cursor;
+                }
+            });
+            reporter.Add({"vault", "list_entry_summaries", {{"rows", rows_param}},
+                          static_cast<uint64_t>(reads), summary_ns});
+
+            const struct {
+                const char* name;
+                const char* query;
+            } searches[] = {
+                {"search_prefix", "host12"},
+                {"search_selective", "host" "4242"},
+                {"search_common_term", "shared account"},
+            };
+            for (const auto& search : searches) {
+                double search_ns = MeasureNs([&] {
+                    for (int i = 0; i < reads; ++i) {
+                        vault.SearchEntries(codebook_id, search.query, 50);
+                    }
+                });
+                reporter.Add({"vault", search.name, {{"rows", rows_param}, {"query", search.query}},
+                              static_cast<uint64_t>(reads), search_ns});
+            }
+        }
+        RemoveDatabase(path);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,125 @@
+#include "AsyncExecutor.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+AsyncExecutor::AsyncExecutor(size_t threads, size_t queue_limit, size_t bulk_limit)
+    : queue_limit_(queue_limit)
+{
+    if (threads == 0 || queue_limit == 0) {
+        throw invalid_argument("Invalid executor limits");
+    }
+    // 单线程时仍允许批量任务运行，否则它们永远得不到线程
+    bulk_limit_ = bulk_limit ? min(bulk_limit, threads) : max<size_t>(1, threads - 1);
+
+    for (size_t i = 0; i < threads; ++i) {
+        workers_.emplace_back(&AsyncExecutor::WorkerLoop, this);
+    }
+}
+
+AsyncExecutor::~AsyncExecutor() {
+    Stop();
+    Join();
+}
+
+void AsyncExecutor::Stop() {
+    {
+        lock_guard<mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    ready_.notify_all();
+}
+
+void AsyncExecutor::Join() {
+    for (thread& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+bool AsyncExecutor::Stopping() const {
+    lock_guard<mutex> lock(mutex_);
+    return stopping_;
+}
+
+size_t AsyncExecutor::Pending(Lane lane) const {
+    lock_guard<mutex> lock(mutex_);
+    return lane == Lane::Interactive ? interactive_.size() : bulk_.size();
+}
+
+bool AsyncExecutor::Post(coroutine_handle<> handle, Lane lane) {
+    {
+        lock_guard<mutex> lock(mutex_);
+        deque<coroutine_handle<>>& queue = lane == Lane::Interactive ? interactive_ : bulk_;
+        if (stopping_ || queue.size() >= queue_limit_) {
+            return false;
+        }
+        queue.push_back(handle);
+    }
+    ready_.notify_one();
+    return true;
+}
+
+void AsyncExecutor::WorkerLoop() {
+    for (;;) {
+        coroutine_handle<> handle;
+        bool bulk = false;
+        {
+            unique_lock<mutex> lock(mutex_);
+            // 关闭时不再限制批量并发，尽快排空
+            auto bulkReady = [this] { return !bulk_.empty() && (stopping_ || bulk_running_ < bulk_limit_); };
+            ready_.wait(lock, [&] { return stopping_ || !interactive_.empty() || bulkReady(); });
+            if (!interactive_.empty()) {
+                handle = interactive_.front();
+                interactive_.pop_front();
+            } else if (bulkReady()) {
+                handle = bulk_.front();
+                bulk_.pop_front();
+                bulk = true;
+                ++bulk_running_;
+            } else {
+                return;
+            }
+        }
+
+        // resume 返回即协程已在下一个挂起点让出（或已结束），线程不再被它占用
+        handle.resume();
+
+        if (bulk) {
+            {
+                lock_guard<mutex> lock(mutex_);
+                --bulk_running_;
+            }
+            ready_.notify_one();
+        }
+    }
+}
+
+bool AsyncExecutor::ScheduleAwaiter::await_ready() const {
+    token_.ThrowIfCancelled();
+    return false;
+}
+
+bool AsyncExecutor::ScheduleAwaiter::await_suspend(coroutine_handle<> handle) {
+    // 入队成功后协程可能已在工作线程上恢复，之后不能再访问 this
+    if (executor_.Post(handle, lane_)) {
+        return true;
+    }
+    rejected_ = true;
+    return false;
+}
+
+void AsyncExecutor::ScheduleAwaiter::await_resume() const {
+    if (rejected_) {
+        if (executor_.Stopping()) {
+            throw OperationCancelled("Executor is shutting down");
+        }
+        throw runtime_error("Executor queue is full");
+    }
+    if (executor_.Stopping()) {
+        throw OperationCancelled("Executor is shutting down");
+    }
+    token_.ThrowIfCancelled();
+}
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "AsyncTask.h"
+
+// 协程执行器：co_await Schedule(lane) 把当前协程移到工作线程上继续。
+// 交互请求优先出队；批量任务最多同时占用 bulk_limit 个线程（默认比线程数少一个），
+// 大批量导入再慢也总留有线程处理交互请求。单线程执行器例外：批量任务只能与交互请求
+// 共用唯一的线程，交互请求仍优先出队，但须等当前批量任务让出线程（或分段结束）才能运行。
+// 两条队列各自有界，已满时 Schedule 直接抛出 runtime_error，由调用方决定重试或拒绝请求
+class AsyncExecutor {
+public:
+    enum class Lane { Interactive, Bulk };
+
+    // bulk_limit 为 0 时取 threads - 1，且至少为 1，因此 threads 为 1 时批量任务可占用唯一线程
+    AsyncExecutor(size_t threads, size_t queue_limit = 1024, size_t bulk_limit = 0);
+    ~AsyncExecutor();
+
+    AsyncExecutor(const AsyncExecutor&) = delete;
+    AsyncExecutor& operator=(const AsyncExecutor&) = delete;
+
+    class ScheduleAwaiter {
+    public:
+        ScheduleAwaiter(AsyncExecutor& executor, Lane lane, CancellationToken token)
+            : executor_(executor), lane_(lane), token_(std::move(token)) {}
+
+        bool await_ready() const;
+        bool await_suspend(std::coroutine_handle<> handle);
+        // 出队时已取消或执行器正在关闭则抛出 OperationCancelled
+        void await_resume() const;
+
+    private:
+        AsyncExecutor& executor_;
+        Lane lane_;
+        CancellationToken token_;
+        bool rejected_ = false;
+    };
+
+    ScheduleAwaiter Schedule(Lane lane, CancellationToken token = CancellationToken()) {
+        return ScheduleAwaiter(*this, lane, std::move(token));
+    }
+
+    // 停止接收新任务；已排队的协程仍会被恢复，并在挂起点抛出 OperationCancelled
+    void Stop();
+    // Stop 后等待工作线程排空队列并退出；不能在本执行器的工作线程上调用
+    void Join();
+    bool Stopping() const;
+    size_t Threads() const { return workers_.size(); }
+    size_t Pending(Lane lane) const;
+
+private:
+    bool Post(std::coroutine_handle<> handle, Lane lane);
+    void WorkerLoop();
+
+    std::vector<std::thread> workers_;
+    std::deque<std::coroutine_handle<>> interactive_;
+    std::deque<std::coroutine_handle<>> bulk_;
+    size_t queue_limit_;
+    size_t bulk_limit_;
+    size_t bulk_running_ = 0;
+    bool stopping_ = false;
+    mutable std::mutex mutex_;
+    std::condition_variable ready_;
+};
\ No newline at end of file
@@ -0,0 +1,209 @@
+#pragma once
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <future>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// 取消或执行器关闭时，挂起点恢复后抛出
+class OperationCancelled : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+// 只读取消标记；默认构造的标记永不取消
+class CancellationToken {
+public:
+    CancellationToken() = default;
+
+    bool IsCancelled() const { return state_ && state_->load(std::memory_order_acquire); }
+    void ThrowIfCancelled() const {
+        if (IsCancelled()) {
+            throw OperationCancelled("Operation cancelled");
+        }
+    }
+
+private:
+    friend class CancellationSource;
+    explicit CancellationToken(std::shared_ptr<std::atomic<bool>> state) : state_(std::move(state)) {}
+
+    std::shared_ptr<std::atomic<bool>> state_;
+};
+
+class CancellationSource {
+public:
+    CancellationSource() : state_(std::make_shared<std::atomic<bool>>(false)) {}
+
+    CancellationToken Token() const { return CancellationToken(state_); }
+    void Cancel() { state_->store(true, std::memory_order_release); }
+    bool IsCancelled() const { return state_->load(std::memory_order_acquire); }
+
+private:
+    std::shared_ptr<std::atomic<bool>> state_;
+};
+
+template <typename T>
+class Task;
+
+namespace detail {
+
+template <typename T>
+struct TaskPromiseBase {
+    std::exception_ptr error;
+    std::coroutine_handle<> continuation = std::noop_coroutine();
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    // 结束时对称转移回等待者，不在执行线程上多占一层栈
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+            return handle.promise().continuation;
+        }
+        void await_resume() noexcept {}
+    };
+    FinalAwaiter final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() { error = std::current_exception(); }
+};
+
+template <typename T>
+struct TaskPromise : TaskPromiseBase<T> {
+    std::optional<T> value;
+
+    Task<T> get_return_object();
+    template <typename U>
+    void return_value(U&& result) { value.emplace(std::forward<U>(result)); }
+
+    T take() {
+        if (this->error) {
+            std::rethrow_exception(this->error);
+        }
+        return std::move(*value);
+    }
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase<void> {
+    Task<void> get_return_object();
+    void return_void() {}
+
+    void take() {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+};
+
+} // namespace detail
+
+// 惰性协程任务：被 co_await 时才开始执行，完成后在最后一个挂起点所在的线程上恢复等待者。
+// 只能等待一次。非协程代码用 Detach 或 ToFuture 启动
+template <typename T>
+class [[nodiscard]] Task {
+public:
+    using promise_type = detail::TaskPromise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    explicit Task(Handle handle) : handle_(handle) {}
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) {
+                handle_.destroy();
+            }
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle_.promise().continuation = awaiting;
+        return handle_;
+    }
+    T await_resume() { return handle_.promise().take(); }
+
+private:
+    Handle handle_;
+};
+
+namespace detail {
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() {
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() {
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+// 自行销毁的驱动协程，承接 Detach/ToFuture
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+template <typename T, typename Callback>
+DetachedTask RunDetached(Task<T> task, Callback callback) {
+    std::exception_ptr error;
+    if constexpr (std::is_void_v<T>) {
+        try {
+            co_await std::move(task);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        callback(error);
+    } else {
+        std::optional<T> result;
+        try {
+            result.emplace(co_await std::move(task));
+        } catch (...) {
+            error = std::current_exception();
+        }
+        callback(result ? std::move(*result) : T(), error);
+    }
+}
+
+} // namespace detail
+
+// 启动任务，完成后在执行线程上调用 callback(result, error)（void 任务为 callback(error)）。
+// 与 UserAuth 的回调版本相同，error 非空时 result 为默认值
+template <typename T, typename Callback>
+void Detach(Task<T> task, Callback callback) {
+    detail::RunDetached(std::move(task), std::move(callback));
+}
+
+template <typename T>
+std::future<T> ToFuture(Task<T> task) {
+    auto promise = std::make_shared<std::promise<T>>();
+    std::future<T> future = promise->get_future();
+    if constexpr (std::is_void_v<T>) {
+        Detach(std::move(task), [promise](std::exception_ptr error) {
+            error ? promise->set_exception(error) : promise->set_value();
+        });
+    } else {
+        Detach(std::move(task), [promise](T result, std::exception_ptr error) {
+            error ? promise->set_exception(error) : promise->set_value(std::move(result));
+        });
+    }
+    return future;
+}
\ No newline at end of file
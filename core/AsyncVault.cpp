@@ -0,0 +1,103 @@
+#include "AsyncVault.h"
+#include <algorithm>
+#include <thread>
+#include "Metrics.h"
+
+using namespace std;
+
+namespace {
+
+using Lane = AsyncExecutor::Lane;
+
+size_t CpuThreads(size_t requested, size_t memlimit) {
+    size_t cores = max(1u, thread::hardware_concurrency());
+    size_t limit = requested ? requested : cores;
+    // 与 HashingPool 相同，只按一半空闲内存计算并发
+    size_t by_memory = memlimit ? HashingPool::AvailableMemory() / 2 / memlimit : limit;
+    return max<size_t>(1, min(limit, by_memory));
+}
+
+} // namespace
+
+AsyncVault::AsyncVault(UserAuth& auth, PasswordVault& vault, const Options& options)
+    : auth_(auth),
+      vault_(vault),
+      io_(options.io_threads, options.queue_limit),
+      cpu_(CpuThreads(options.cpu_threads, auth.policy_.memlimit), options.queue_limit)
+{
+}
+
+// 协程在两个执行器之间往返：任一执行器的线程退出前都可能把协程排到另一个上。
+// 先停止两者，再等两边的线程都退出，成员析构时已没有线程会访问 io_ 或 cpu_
+AsyncVault::~AsyncVault() {
+    Stop();
+    io_.Join();
+    cpu_.Join();
+}
+
+void AsyncVault::Stop() {
+    io_.Stop();
+    cpu_.Stop();
+}
+
+Task<WriteResult> AsyncVault::AddEntry(int codebook_id, string address, string public_key,
+                                       string encrypted_password, string notes,
+                                       CancellationToken token) {
+    co_await io_.Schedule(Lane::Interactive, token);
+    co_return vault_.AddEntry(codebook_id, address, public_key, encrypted_password, notes);
+}
+
+Task<vector<PasswordVault::BatchResult>> AsyncVault::AddEntries(int codebook_id,
+                                                                vector<PasswordVault::EntryInput> entries,
+                                                                CancellationToken token,
+                                                                size_t batch_size) {
+    batch_size = max<size_t>(1, batch_size);
+    vector<PasswordVault::BatchResult> results;
+    results.reserve(entries.size());
+
+    span<const PasswordVault::EntryInput> rest(entries);
+    while (!rest.empty()) {
+        // 每段单独排队，两段之间让出线程给交互请求
+        co_await io_.Schedule(Lane::Bulk, token);
+        size_t count = min(batch_size, rest.size());
+        vector<PasswordVault::BatchResult> batch = vault_.AddEntries(codebook_id, rest.first(count));
+        results.insert(results.end(), make_move_iterator(batch.begin()), make_move_iterator(batch.end()));
+        rest = rest.subspan(count);
+    }
+    co_return results;
+}
+
+Task<vector<PasswordVault::PasswordEntry>> AsyncVault::GetEntries(int codebook_id, string filter,
+                                                                  int page, int page_size,
+                                                                  CancellationToken token) {
+    co_await io_.Schedule(Lane::Interactive, token);
+    co_return vault_.GetEntries(codebook_id, filter, page, page_size);
+}
+
+Task<UserAuth::LoginResult> AsyncVault::Login(string username, string password, CancellationToken token) {
+    Metrics::ScopedTimer timer(Metrics::Op::AuthLogin);
+    UserAuth::LoginResult result{false, {}};
+
+    co_await io_.Schedule(Lane::Interactive, token);
+    string stored_hash;
+    if (!auth_.GetUserHash(username, stored_hash)) {
+        co_return result;
+    }
+
+    co_await cpu_.Schedule(Lane::Interactive, token);
+    if (!auth_.VerifyPassword(stored_hash, password)) {
+        co_return result;
+    }
+    // 重算哈希同样是 Argon2，留在 CPU 执行器上；之后不再检查取消，已校验的登录照常完成
+    auth_.RehashIfNeeded(username, password, stored_hash);
+
+    co_await io_.Schedule(Lane::Interactive);
+    result.success = auth_.GetUserCodebooks(username, result.codebooks);
+    co_return result;
+}
+
+Task<size_t> AsyncVault::Decrypt(CryptoSession& session, vector<uint8_t> packed, span<uint8_t> out,
+                                 CancellationToken token) {
+    co_await cpu_.Schedule(Lane::Interactive, token);
+    co_return session.decrypt(span<const uint8_t>(packed), out);
+}
\ No newline at end of file
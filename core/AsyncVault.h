@@ -0,0 +1,73 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+#include "AsyncExecutor.h"
+#include "AsyncTask.h"
+#include "CryptoSession.h"
+#include "PassWordVault.h"
+#include "UserAuth.h"
+
+// 协程接口：co_await 的每个调用都在内部执行器上完成，调用线程（如 asio 的 io 线程）不被阻塞。
+//  - IO 执行器跑 SQLite 语句，写操作仍经 Database 的单写者队列串行；
+//  - CPU 执行器跑 Argon2 与解密，线程数按内存 / memlimit 限制，KDF 突发不会占满 IO 线程。
+// 交互请求（单条写入、列表、登录）优先于批量写入；批量写入按 batch_size 分段，
+// 每段重新排队，交互请求可插在两段之间。
+// 取消在挂起点生效：已开始的 SQLite 语句与 KDF 不会被打断，已提交的分段保留。
+// 队列满时抛出 runtime_error，关闭中或已取消抛出 OperationCancelled。
+// 所有参数按值保存在协程帧中；auth、vault 与 CryptoSession 须在任务完成前保持存活
+class AsyncVault {
+public:
+    struct Options {
+        size_t io_threads = 4;         // 取 1 时批量写入的分段会与交互请求轮流占用同一线程
+        size_t cpu_threads = 0;        // 0 取 CPU 核数，并受可用内存 / KDF memlimit 限制
+        size_t queue_limit = 1024;     // 每条队列的上限
+    };
+
+    AsyncVault(UserAuth& auth, PasswordVault& vault, const Options& options);
+    AsyncVault(UserAuth& auth, PasswordVault& vault) : AsyncVault(auth, vault, Options()) {}
+    ~AsyncVault();
+
+    AsyncVault(const AsyncVault&) = delete;
+    AsyncVault& operator=(const AsyncVault&) = delete;
+
+    Task<WriteResult> AddEntry(int codebook_id,
+                               std::string address,
+                               std::string public_key,
+                               std::string encrypted_password,
+                               std::string notes = "",
+                               CancellationToken token = CancellationToken());
+    // 返回已提交分段的逐行结果；中途取消时抛出 OperationCancelled，之前的分段不回滚
+    Task<std::vector<PasswordVault::BatchResult>> AddEntries(int codebook_id,
+                                                             std::vector<PasswordVault::EntryInput> entries,
+                                                             CancellationToken token = CancellationToken(),
+                                                             size_t batch_size = 500);
+    Task<std::vector<PasswordVault::PasswordEntry>> GetEntries(int codebook_id,
+                                                               std::string filter = "",
+                                                               int page = 0,
+                                                               int page_size = 50,
+                                                               CancellationToken token = CancellationToken());
+    // 与 UserAuth::Login 相同：查哈希（IO）→ 校验与重算哈希（CPU）→ 读密码本列表（IO）
+    Task<UserAuth::LoginResult> Login(std::string username,
+                                      std::string password,
+                                      CancellationToken token = CancellationToken());
+    // CryptoSession::decrypt 的 span 版本，out 须在任务完成前保持有效
+    Task<size_t> Decrypt(CryptoSession& session,
+                         std::vector<uint8_t> packed,
+                         std::span<uint8_t> out,
+                         CancellationToken token = CancellationToken());
+
+    // 停止接收新请求，排队中的请求以 OperationCancelled 结束
+    void Stop();
+
+    AsyncExecutor& IoExecutor() { return io_; }
+    AsyncExecutor& CpuExecutor() { return cpu_; }
+
+private:
+    UserAuth& auth_;
+    PasswordVault& vault_;
+    AsyncExecutor io_;
+    AsyncExecutor cpu_;
+};
\ No newline at end of file
@@ -0,0 +1,126 @@
+#include "BreachList.h"
+#include <sodium.h>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+BreachList::BreachList(const std::string& path, size_t recordSize) : recordSize_(recordSize) {
+    if (recordSize < 4 || recordSize > DIGEST_SIZE) {
+        throw std::invalid_argument("Invalid breach list record size");
+    }
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Cannot open breach list");
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        throw std::runtime_error("Cannot open breach list");
+    }
+    bytes_ = static_cast<size_t>(size.QuadPart);
+    file_ = file;
+    if (bytes_ > 0) {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (!view) {
+            if (mapping) {
+                CloseHandle(mapping);
+            }
+            CloseHandle(file);
+            throw std::runtime_error("Cannot map breach list");
+        }
+        mapping_ = mapping;
+        data_ = static_cast<const uint8_t*>(view);
+    }
+#else
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open breach list");
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw std::runtime_error("Cannot open breach list");
+    }
+    bytes_ = static_cast<size_t>(st.st_size);
+    if (bytes_ > 0) {
+        void* view = mmap(nullptr, bytes_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("Cannot map breach list");
+        }
+        // Lookups land on random pages; readahead would only evict useful cache
+        madvise(view, bytes_, MADV_RANDOM);
+        data_ = static_cast<const uint8_t*>(view);
+    }
+    // The mapping stays valid after the descriptor is closed
+    close(fd);
+#endif
+
+    if (bytes_ % recordSize_ != 0) {
+        unmap();
+        throw std::runtime_error("Breach list size is not a multiple of the record size");
+    }
+    count_ = bytes_ / recordSize_;
+}
+
+BreachList::~BreachList() {
+    unmap();
+}
+
+void BreachList::unmap() noexcept {
+#ifdef _WIN32
+    if (data_) {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_) {
+        CloseHandle(mapping_);
+    }
+    if (file_) {
+        CloseHandle(file_);
+    }
+    file_ = mapping_ = nullptr;
+#else
+    if (data_) {
+        munmap(const_cast<uint8_t*>(data_), bytes_);
+    }
+#endif
+    data_ = nullptr;
+}
+
+bool BreachList::contains(std::string_view password) const {
+    uint8_t digest[DIGEST_SIZE];
+    crypto_hash_sha256(digest, reinterpret_cast<const unsigned char*>(password.data()), password.size());
+    bool found = containsDigest(digest);
+    sodium_memzero(digest, sizeof(digest));
+    return found;
+}
+
+bool BreachList::containsDigest(const uint8_t* digest) const {
+    size_t low = 0;
+    size_t high = count_;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        int order = std::memcmp(data_ + mid * recordSize_, digest, recordSize_);
+        if (order == 0) {
+            return true;
+        }
+        if (order < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return false;
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Read-only set of breached passwords, memory-mapped from a file of SHA-256
+// digests (optionally truncated to the first recordSize bytes) in ascending
+// byte order with no separators. The file is meant to be assembled from
+// k-anonymity range queries: only digest prefixes ever leave the host, and
+// the downloaded suffixes are merged and sorted locally. Lookups hash the
+// candidate and binary-search the mapping, so the set costs page cache, not
+// heap, and opening a multi-GB list is O(1). Shorter records trade a small
+// false-positive rate for size. Safe to share between threads.
+class BreachList {
+public:
+    static constexpr size_t DIGEST_SIZE = 32;
+
+    // Throws std::runtime_error if the file cannot be mapped or its size is
+    // not a multiple of recordSize; recordSize must be in [4, DIGEST_SIZE]
+    explicit BreachList(const std::string& path, size_t recordSize = DIGEST_SIZE);
+    ~BreachList();
+
+    BreachList(const BreachList&) = delete;
+    BreachList& operator=(const BreachList&) = delete;
+
+    bool contains(std::string_view password) const;
+    // digest must hold at least recordSize() bytes
+    bool containsDigest(const uint8_t* digest) const;
+
+    size_t size() const { return count_; }
+    size_t recordSize() const { return recordSize_; }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t bytes_ = 0;
+    size_t count_ = 0;
+    size_t recordSize_;
+    void unmap() noexcept;
+
+#ifdef _WIN32
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#endif
+};
\ No newline at end of file
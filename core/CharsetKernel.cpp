@@ -0,0 +1,305 @@
+#include "CharsetKernel.h"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MYPASSWD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define MYPASSWD_NEON 1
+#include <arm_neon.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define MYPASSWD_TARGET(isa) __attribute__((target(isa)))
+#else
+#define MYPASSWD_TARGET(isa)
+#endif
+
+namespace {
+
+using KernelFn = size_t (*)(const SamplingTable&, const unsigned char*, size_t, char*);
+
+size_t MapScalar(const SamplingTable& table, const unsigned char* in, size_t count, char* out)
+{
+    size_t written = 0;
+    for (size_t i = 0; i < count; ++i) {
+        out[written] = table.map[in[i]];
+        written += in[i] < table.limit;
+    }
+    return written;
+}
+
+#ifdef MYPASSWD_X86
+
+// kCompress[m] 是把 8 字节中 mask 位为 1 的字节前移的 pshufb 控制字
+struct CompressTable {
+    alignas(16) uint8_t shuffle[256][8];
+    uint8_t count[256];
+
+    constexpr CompressTable() : shuffle(), count()
+    {
+        for (int m = 0; m < 256; ++m) {
+            int k = 0;
+            for (int bit = 0; bit < 8; ++bit) {
+                if (m & (1 << bit)) {
+                    shuffle[m][k++] = static_cast<uint8_t>(bit);
+                }
+            }
+            for (int rest = k; rest < 8; ++rest) {
+                shuffle[m][rest] = 0x80;
+            }
+            count[m] = static_cast<uint8_t>(k);
+        }
+    }
+};
+
+constexpr CompressTable kCompress;
+
+// 把 16 字节中被接受的字节依次写到 out，返回写入数
+MYPASSWD_TARGET("sse4.1")
+inline size_t Compress16(__m128i chars, unsigned mask, char* out)
+{
+    const unsigned lo = mask & 0xFF;
+    const unsigned hi = (mask >> 8) & 0xFF;
+
+    __m128i lo_shuffle = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(kCompress.shuffle[lo]));
+    __m128i hi_shuffle = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(kCompress.shuffle[hi]));
+    __m128i lo_out = _mm_shuffle_epi8(chars, lo_shuffle);
+    __m128i hi_out = _mm_shuffle_epi8(_mm_srli_si128(chars, 8), hi_shuffle);
+
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out), lo_out);
+    size_t written = kCompress.count[lo];
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out + written), hi_out);
+    return written + kCompress.count[hi];
+}
+
+// 256 项查表拆成 16 段：按高半字节选段，段内用 pshufb 按低半字节取值
+MYPASSWD_TARGET("sse4.1")
+inline __m128i Lookup16(const SamplingTable& table, __m128i bytes)
+{
+    const __m128i low_nibble = _mm_and_si128(bytes, _mm_set1_epi8(0x0F));
+    const __m128i high_nibble = _mm_and_si128(_mm_srli_epi16(bytes, 4), _mm_set1_epi8(0x0F));
+    __m128i result = _mm_setzero_si128();
+    for (int h = 0; h < 16; ++h) {
+        __m128i segment = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&table.map[h * 16]));
+        __m128i hit = _mm_cmpeq_epi8(high_nibble, _mm_set1_epi8(static_cast<char>(h)));
+        result = _mm_or_si128(result, _mm_and_si128(hit, _mm_shuffle_epi8(segment, low_nibble)));
+    }
+    return result;
+}
+
+// 无符号比较 bytes < limit；limit == 256 时全部接受
+MYPASSWD_TARGET("sse4.1")
+inline unsigned AcceptMask16(__m128i bytes, unsigned limit)
+{
+    if (limit >= 256) {
+        return 0xFFFF;
+    }
+    const __m128i max_ok = _mm_set1_epi8(static_cast<char>(limit - 1));
+    __m128i ok = _mm_cmpeq_epi8(_mm_min_epu8(bytes, max_ok), bytes);
+    return static_cast<unsigned>(_mm_movemask_epi8(ok));
+}
+
+MYPASSWD_TARGET("sse4.1")
+size_t MapSSE41(const SamplingTable& table, const unsigned char* in, size_t count, char* out)
+{
+    size_t written = 0;
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        __m128i chars = Lookup16(table, bytes);
+        written += Compress16(chars, AcceptMask16(bytes, table.limit), out + written);
+    }
+    return written + MapScalar(table, in + i, count - i, out + written);
+}
+
+MYPASSWD_TARGET("avx2")
+size_t MapAVX2(const SamplingTable& table, const unsigned char* in, size_t count, char* out)
+{
+    const __m256i nibble_mask = _mm256_set1_epi8(0x0F);
+    __m256i segments[16];
+    for (int h = 0; h < 16; ++h) {
+        segments[h] = _mm256_broadcastsi128_si256(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(&table.map[h * 16])));
+    }
+    const bool accept_all = table.limit >= 256;
+    const __m256i max_ok = _mm256_set1_epi8(static_cast<char>(accept_all ? 0xFF : table.limit - 1));
+
+    size_t written = 0;
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        __m256i low_nibble = _mm256_and_si256(bytes, nibble_mask);
+        __m256i high_nibble = _mm256_and_si256(_mm256_srli_epi16(bytes, 4), nibble_mask);
+
+        __m256i chars = _mm256_setzero_si256();
+        for (int h = 0; h < 16; ++h) {
+            __m256i hit = _mm256_cmpeq_epi8(high_nibble, _mm256_set1_epi8(static_cast<char>(h)));
+            chars = _mm256_or_si256(chars, _mm256_and_si256(hit, _mm256_shuffle_epi8(segments[h], low_nibble)));
+        }
+
+        __m256i ok = _mm256_cmpeq_epi8(_mm256_min_epu8(bytes, max_ok), bytes);
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(ok));
+
+        written += Compress16(_mm256_castsi256_si128(chars), mask & 0xFFFF, out + written);
+        written += Compress16(_mm256_extracti128_si256(chars, 1), mask >> 16, out + written);
+    }
+    return written + MapScalar(table, in + i, count - i, out + written);
+}
+
+bool CpuHasSSE41()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 19)) != 0;
+#else
+    return __builtin_cpu_supports("sse4.1");
+#endif
+}
+
+bool CpuHasAVX2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // MYPASSWD_X86
+
+#ifdef MYPASSWD_NEON
+
+size_t MapNEON(const SamplingTable& table, const unsigned char* in, size_t count, char* out)
+{
+    // vqtbl4q 一次查 64 项，越界索引得 0，四段结果按位或即为 256 项查表
+    uint8x16x4_t quarters[4];
+    for (int q = 0; q < 4; ++q) {
+        quarters[q] = vld1q_u8_x4(reinterpret_cast<const uint8_t*>(&table.map[q * 64]));
+    }
+    const bool accept_all = table.limit >= 256;
+    const uint8x16_t max_ok = vdupq_n_u8(static_cast<uint8_t>(accept_all ? 0xFF : table.limit - 1));
+
+    size_t written = 0;
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        uint8x16_t bytes = vld1q_u8(in + i);
+        uint8x16_t chars = vqtbl4q_u8(quarters[0], bytes);
+        chars = vorrq_u8(chars, vqtbl4q_u8(quarters[1], vsubq_u8(bytes, vdupq_n_u8(64))));
+        chars = vorrq_u8(chars, vqtbl4q_u8(quarters[2], vsubq_u8(bytes, vdupq_n_u8(128))));
+        chars = vorrq_u8(chars, vqtbl4q_u8(quarters[3], vsubq_u8(bytes, vdupq_n_u8(192))));
+        uint8x16_t ok = vcleq_u8(bytes, max_ok);
+
+        alignas(16) uint8_t lane_chars[16];
+        alignas(16) uint8_t lane_ok[16];
+        vst1q_u8(lane_chars, chars);
+        vst1q_u8(lane_ok, ok);
+        for (int lane = 0; lane < 16; ++lane) {
+            out[written] = static_cast<char>(lane_chars[lane]);
+            written += lane_ok[lane] & 1;
+        }
+    }
+    return written + MapScalar(table, in + i, count - i, out + written);
+}
+
+#endif // MYPASSWD_NEON
+
+struct KernelChoice {
+    CharsetKernelIsa isa;
+    KernelFn fn;
+};
+
+KernelChoice DetectKernel()
+{
+#ifdef MYPASSWD_X86
+    if (CpuHasAVX2()) {
+        return {CharsetKernelIsa::AVX2, MapAVX2};
+    }
+    if (CpuHasSSE41()) {
+        return {CharsetKernelIsa::SSE41, MapSSE41};
+    }
+#endif
+#ifdef MYPASSWD_NEON
+    return {CharsetKernelIsa::NEON, MapNEON};
+#endif
+    return {CharsetKernelIsa::Scalar, MapScalar};
+}
+
+std::atomic<int> g_active_isa{-1};
+std::atomic<KernelFn> g_active_fn{nullptr};
+
+KernelFn ActiveFn()
+{
+    KernelFn fn = g_active_fn.load(std::memory_order_acquire);
+    if (!fn) {
+        KernelChoice choice = DetectKernel();
+        g_active_isa.store(static_cast<int>(choice.isa), std::memory_order_relaxed);
+        g_active_fn.store(choice.fn, std::memory_order_release);
+        fn = choice.fn;
+    }
+    return fn;
+}
+
+} // namespace
+
+size_t MapCharsetBlock(const SamplingTable& table, const unsigned char* in, size_t count, char* out)
+{
+    return ActiveFn()(table, in, count, out);
+}
+
+CharsetKernelIsa ActiveCharsetKernel()
+{
+    ActiveFn();
+    return static_cast<CharsetKernelIsa>(g_active_isa.load(std::memory_order_relaxed));
+}
+
+bool SelectCharsetKernel(CharsetKernelIsa isa)
+{
+    KernelFn fn = nullptr;
+    switch (isa) {
+    case CharsetKernelIsa::Scalar:
+        fn = MapScalar;
+        break;
+#ifdef MYPASSWD_X86
+    case CharsetKernelIsa::SSE41:
+        fn = CpuHasSSE41() ? MapSSE41 : nullptr;
+        break;
+    case CharsetKernelIsa::AVX2:
+        fn = CpuHasAVX2() ? MapAVX2 : nullptr;
+        break;
+#endif
+#ifdef MYPASSWD_NEON
+    case CharsetKernelIsa::NEON:
+        fn = MapNEON;
+        break;
+#endif
+    default:
+        break;
+    }
+    if (!fn) {
+        return false;
+    }
+    g_active_isa.store(static_cast<int>(isa), std::memory_order_relaxed);
+    g_active_fn.store(fn, std::memory_order_release);
+    return true;
+}
\ No newline at end of file
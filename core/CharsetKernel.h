@@ -0,0 +1,22 @@
+#pragma once
+#include <cstddef>
+#include "CharsetTable.h"
+
+enum class CharsetKernelIsa {
+    Scalar,
+    SSE41,
+    AVX2,
+    NEON
+};
+
+// 输出缓冲区需要比输入多出的字节数（向量压缩写入会越过有效末尾）
+constexpr size_t kCharsetKernelSlack = 32;
+
+// 把一块随机字节按 SamplingTable 映射为字符，并剔除 >= limit 的字节。
+// out 至少需要 count + kCharsetKernelSlack 字节；返回有效字符数。
+// 首次调用时按 CPU 能力选择 AVX2 / SSE4.1 / NEON 实现，否则使用标量版本
+size_t MapCharsetBlock(const SamplingTable& table, const unsigned char* in, size_t count, char* out);
+
+CharsetKernelIsa ActiveCharsetKernel();
+// 强制使用指定实现（基准测试对比用）；CPU 不支持时返回 false 且保持不变
+bool SelectCharsetKernel(CharsetKernelIsa isa);
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <string_view>
+#include "PasswordPolicy.h"
+
+// 随机字节 -> 字符的查表映射。map[b] 预先算好 charset[b % size]，
+// 字节 b >= limit 时拒绝以保证均匀，内层循环只剩一次查表和一次比较
+struct SamplingTable {
+    std::array<char, 256> map{};
+    unsigned limit = 0;
+    size_t size = 0;
+
+    static constexpr SamplingTable FromCharset(std::string_view chars) {
+        SamplingTable table;
+        table.size = chars.size();
+        if (table.size == 0 || table.size > 256) {
+            return table;
+        }
+        table.limit = 256 - (256 % table.size);
+        for (size_t b = 0; b < 256; ++b) {
+            table.map[b] = chars[b % table.size];
+        }
+        return table;
+    }
+
+    static constexpr SamplingTable FromClasses(unsigned classes, bool exclude_ambiguous) {
+        char chars[256] = {};
+        size_t count = 0;
+        for (std::string_view set : {kUpperChars, kLowerChars, kDigitChars, kSymbolChars}) {
+            if (!(classes & ClassOf(set[0]))) {
+                continue;
+            }
+            for (char c : set) {
+                if (!exclude_ambiguous || !IsAmbiguous(c)) {
+                    chars[count++] = c;
+                }
+            }
+        }
+        return FromCharset(std::string_view(chars, count));
+    }
+};
+
+// 编译期特化的字符表
+template <unsigned Classes, bool ExcludeAmbiguous>
+inline constexpr SamplingTable kSamplingTable = SamplingTable::FromClasses(Classes, ExcludeAmbiguous);
\ No newline at end of file
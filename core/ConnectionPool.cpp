@@ -0,0 +1,53 @@
+#include "ConnectionPool.h"
+#include <stdexcept>
+
+using namespace std;
+
+ConnectionPool::Lease::Lease(ConnectionPool* pool, Database* db) : pool_(pool), db_(db) {
+    if (!pool_) {
+        writer_lock_ = db_->Lock();
+    }
+}
+
+ConnectionPool::Lease::Lease(Lease&& other) noexcept
+    : pool_(other.pool_), db_(other.db_), writer_lock_(move(other.writer_lock_)) {
+    other.pool_ = nullptr;
+    other.db_ = nullptr;
+}
+
+ConnectionPool::Lease::~Lease() {
+    if (pool_ && db_) {
+        pool_->Release(db_);
+    }
+}
+
+ConnectionPool::ConnectionPool(const string& path, const StorageProfile& profile, size_t size) {
+    if (size == 0) {
+        throw invalid_argument("Connection pool size must be positive");
+    }
+
+    for (size_t i = 0; i < size; ++i) {
+        // 池负责串行化每个连接的使用，可关闭 SQLite 自身的连接互斥
+        auto db = make_unique<Database>(path, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX);
+        db->Configure(profile, true);
+        idle_.push_back(db.get());
+        connections_.push_back(move(db));
+    }
+}
+
+ConnectionPool::Lease ConnectionPool::Acquire() {
+    unique_lock<mutex> lock(mutex_);
+    available_.wait(lock, [this] { return !idle_.empty(); });
+
+    Database* db = idle_.back();
+    idle_.pop_back();
+    return Lease(this, db);
+}
+
+void ConnectionPool::Release(Database* db) {
+    {
+        lock_guard<mutex> lock(mutex_);
+        idle_.push_back(db);
+    }
+    available_.notify_one();
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include <vector>
+#include "Database.h"
+
+// 只读连接池：WAL 模式下读连接不会被写事务阻塞。
+// 每个连接拥有独立的语句缓存，同一时刻只借给一个调用方
+class ConnectionPool {
+public:
+    class Lease {
+    public:
+        // pool 为空时借用写连接，租期内持有其写锁
+        Lease(ConnectionPool* pool, Database* db);
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&&) = delete;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        ~Lease();
+
+        Database& operator*() const { return *db_; }
+        Database* operator->() const { return db_; }
+
+    private:
+        ConnectionPool* pool_;   // 为空表示借用的是写连接，不归还
+        Database* db_;
+        std::unique_lock<WriterQueue> writer_lock_;
+    };
+
+    ConnectionPool(const std::string& path, const StorageProfile& profile, size_t size);
+
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    // 全部连接被占用时阻塞等待
+    Lease Acquire();
+    size_t Size() const { return connections_.size(); }
+
+private:
+    void Release(Database* db);
+
+    std::vector<std::unique_ptr<Database>> connections_;
+    std::vector<Database*> idle_;
+    std::mutex mutex_;
+    std::condition_variable available_;
+};
\ No newline at end of file
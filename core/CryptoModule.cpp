@@ -1,97 +1,155 @@
 #include "CryptoModule.h"
+#include "Metrics.h"
 #include <sodium.h>
 #include <vector>
 #include <stdexcept>
-#include <iterator>
+#include <cstring>
 
-CryptoModule::CryptoModule() {
+CryptoModule::CryptoModule(const KdfPolicy& policy) : policy_(policy) {
     if (sodium_init() < 0) {
         throw std::runtime_error("Libsodium initialization failed");
     }
 }
 
-std::vector<uint8_t> CryptoModule::encrypt(const std::string& masterPassword, const std::vector<uint8_t>& plaintext) {
-    // Generate random salt
-    std::vector<uint8_t> salt(crypto_pwhash_SALTBYTES);
-    randombytes_buf(salt.data(), salt.size());
-
-    // Derive key using Argon2id
-    std::vector<uint8_t> key(crypto_secretbox_KEYBYTES);
+void CryptoModule::deriveKey(const char* password, size_t passwordLen, const uint8_t* salt, uint8_t* key) {
+    Metrics::ScopedTimer timer(Metrics::Op::Kdf);
+    Metrics::Add(Metrics::Counter::KdfInvocations);
     if (crypto_pwhash(
-        key.data(), key.size(),
-        masterPassword.c_str(), masterPassword.length(),
-        salt.data(),
+        key, crypto_secretbox_KEYBYTES,
+        password, passwordLen,
+        salt,
         crypto_pwhash_OPSLIMIT_MODERATE,
         crypto_pwhash_MEMLIMIT_MODERATE,
         crypto_pwhash_ALG_DEFAULT) != 0) {
         throw std::runtime_error("Key derivation failed");
     }
+}
 
-    // Generate random nonce
-    std::vector<uint8_t> nonce(crypto_secretbox_NONCEBYTES);
-    randombytes_buf(nonce.data(), nonce.size());
-
-    // Encrypt data
-    std::vector<uint8_t> ciphertext(plaintext.size() + crypto_secretbox_MACBYTES);
-    if (crypto_secretbox_easy(
-        ciphertext.data(),
-        plaintext.data(), plaintext.size(),
-        nonce.data(),
-        key.data()) != 0) {
-        throw std::runtime_error("Encryption failed");
+void CryptoModule::deriveKey(const char* password, size_t passwordLen, const KdfHeader& header, uint8_t* key) {
+    Metrics::ScopedTimer timer(Metrics::Op::Kdf);
+    Metrics::Add(Metrics::Counter::KdfInvocations);
+    if (header.salt.size() != crypto_pwhash_SALTBYTES ||
+        crypto_pwhash(
+        key, crypto_secretbox_KEYBYTES,
+        password, passwordLen,
+        header.salt.data(),
+        header.opslimit,
+        static_cast<size_t>(header.memlimit),
+        header.kdf_id) != 0) {
+        throw std::runtime_error("Key derivation failed");
+    }
+}
+
+KdfHeader CryptoModule::createHeader() const {
+    return KdfHeader::create(policy_.opslimit, policy_.memlimit);
+}
+
+std::unique_ptr<CryptoSession> CryptoModule::openSession(const std::string& masterPassword,
+                                                         const KdfHeader& header,
+                                                         std::chrono::seconds idleTimeout) {
+    return std::make_unique<CryptoSession>(masterPassword, header, idleTimeout);
+}
+
+std::unique_ptr<CryptoSession> CryptoModule::openSession(const std::string& masterPassword,
+                                                         const std::vector<uint8_t>& salt,
+                                                         std::chrono::seconds idleTimeout) {
+    KdfHeader header = createHeader();
+    if (!salt.empty()) {
+        header.salt = salt;
     }
+    return std::make_unique<CryptoSession>(masterPassword, header, idleTimeout);
+}
+
+size_t CryptoModule::packedSize(size_t plaintextLen) {
+    return crypto_pwhash_SALTBYTES + crypto_secretbox_NONCEBYTES + crypto_secretbox_MACBYTES + plaintextLen;
+}
 
-    // Combine components
-    std::vector<uint8_t> packedData;
-    packedData.reserve(salt.size() + nonce.size() + ciphertext.size());
-    packedData.insert(packedData.end(), salt.begin(), salt.end());
-    packedData.insert(packedData.end(), nonce.begin(), nonce.end());
-    packedData.insert(packedData.end(), ciphertext.begin(), ciphertext.end());
+size_t CryptoModule::plaintextSize(size_t packedLen) {
+    const size_t minSize = packedSize(0);
+    if (packedLen < minSize) {
+        throw std::runtime_error("Invalid packed data format");
+    }
+    return packedLen - minSize;
+}
 
+std::vector<uint8_t> CryptoModule::encrypt(const std::string& masterPassword, const std::vector<uint8_t>& plaintext) {
+    std::vector<uint8_t> packedData(packedSize(plaintext.size()));
+    encrypt(masterPassword, plaintext, packedData);
     return packedData;
 }
 
 std::vector<uint8_t> CryptoModule::decrypt(const std::string& masterPassword, const std::vector<uint8_t>& packedData) {
-    const size_t minSize = crypto_pwhash_SALTBYTES + crypto_secretbox_NONCEBYTES + crypto_secretbox_MACBYTES;
-    if (packedData.size() < minSize) {
-        throw std::runtime_error("Invalid packed data format");
+    std::vector<uint8_t> plaintext(plaintextSize(packedData.size()));
+    decrypt(masterPassword, packedData, plaintext);
+    return plaintext;
+}
+
+std::span<uint8_t> CryptoModule::decrypt(const std::string& masterPassword, std::span<const uint8_t> packedData,
+                                         SecureArena& arena) {
+    const size_t plaintextLen = plaintextSize(packedData.size());
+    uint8_t* out = static_cast<uint8_t*>(arena.allocate(plaintextLen, 1));
+    try {
+        decrypt(masterPassword, packedData, std::span<uint8_t>(out, plaintextLen));
+    } catch (...) {
+        arena.deallocate(out, plaintextLen);
+        throw;
     }
+    return std::span<uint8_t>(out, plaintextLen);
+}
 
-    // Extract salt
-    auto saltBegin = packedData.begin();
-    auto saltEnd = saltBegin + crypto_pwhash_SALTBYTES;
-    std::vector<uint8_t> salt(saltBegin, saltEnd);
+size_t CryptoModule::encrypt(const std::string& masterPassword, std::span<const uint8_t> plaintext, std::span<uint8_t> out) {
+    Metrics::ScopedTimer timer(Metrics::Op::Encrypt);
+    const size_t total = packedSize(plaintext.size());
+    if (out.size() < total) {
+        throw std::invalid_argument("Output buffer too small");
+    }
 
-    // Extract nonce
-    auto nonceBegin = saltEnd;
-    auto nonceEnd = nonceBegin + crypto_secretbox_NONCEBYTES;
-    std::vector<uint8_t> nonce(nonceBegin, nonceEnd);
+    // Salt and nonce are staged locally so out may alias plaintext
+    uint8_t salt[crypto_pwhash_SALTBYTES];
+    uint8_t nonce[crypto_secretbox_NONCEBYTES];
+    randombytes_buf(salt, sizeof salt);
+    randombytes_buf(nonce, sizeof nonce);
 
-    // Extract ciphertext
-    auto ciphertextBegin = nonceEnd;
-    std::vector<uint8_t> ciphertext(ciphertextBegin, packedData.end());
+    uint8_t key[crypto_secretbox_KEYBYTES];
+    deriveKey(masterPassword.c_str(), masterPassword.length(), salt, key);
 
-    // Re-derive key
-    std::vector<uint8_t> key(crypto_secretbox_KEYBYTES);
-    if (crypto_pwhash(
-        key.data(), key.size(),
-        masterPassword.c_str(), masterPassword.length(),
-        salt.data(),
-        crypto_pwhash_OPSLIMIT_MODERATE,
-        crypto_pwhash_MEMLIMIT_MODERATE,
-        crypto_pwhash_ALG_DEFAULT) != 0) {
-        throw std::runtime_error("Key derivation failed");
+    // crypto_secretbox_easy handles overlapping input and output
+    uint8_t* ciphertext = out.data() + sizeof salt + sizeof nonce;
+    int rc = crypto_secretbox_easy(ciphertext, plaintext.data(), plaintext.size(), nonce, key);
+    sodium_memzero(key, sizeof key);
+    if (rc != 0) {
+        throw std::runtime_error("Encryption failed");
     }
 
-    // Decrypt data
-    std::vector<uint8_t> plaintext(ciphertext.size() - crypto_secretbox_MACBYTES);
-    if (crypto_secretbox_open_easy(
-        plaintext.data(),
-        ciphertext.data(), ciphertext.size(),
-        nonce.data(),
-        key.data()) != 0) {
-        throw std::runtime_error("Decryption failed: incorrect password or corrupted data");
+    std::memcpy(out.data(), salt, sizeof salt);
+    std::memcpy(out.data() + sizeof salt, nonce, sizeof nonce);
+    Metrics::Add(Metrics::Counter::BytesEncrypted, plaintext.size());
+    return total;
+}
+
+size_t CryptoModule::decrypt(const std::string& masterPassword, std::span<const uint8_t> packedData, std::span<uint8_t> out) {
+    Metrics::ScopedTimer timer(Metrics::Op::Decrypt);
+    const size_t plaintextLen = plaintextSize(packedData.size());
+    if (out.size() < plaintextLen) {
+        throw std::invalid_argument("Output buffer too small");
     }
 
-    return plaintext;
+    const uint8_t* salt = packedData.data();
+    const uint8_t* nonce = salt + crypto_pwhash_SALTBYTES;
+    const uint8_t* ciphertext = nonce + crypto_secretbox_NONCEBYTES;
+    const size_t ciphertextLen = plaintextLen + crypto_secretbox_MACBYTES;
+
+    uint8_t key[crypto_secretbox_KEYBYTES];
+    deriveKey(masterPassword.c_str(), masterPassword.length(), salt, key);
+
+    // The nonce is copied first: decrypting in place overwrites it
+    uint8_t nonceCopy[crypto_secretbox_NONCEBYTES];
+    std::memcpy(nonceCopy, nonce, sizeof nonceCopy);
+    int rc = crypto_secretbox_open_easy(out.data(), ciphertext, ciphertextLen, nonceCopy, key);
+    sodium_memzero(key, sizeof key);
+    if (rc != 0) {
+        throw std::runtime_error("Decryption failed: incorrect password or corrupted data");
+    }
+    Metrics::Add(Metrics::Counter::BytesDecrypted, plaintextLen);
+    return plaintextLen;
 }
\ No newline at end of file
@@ -3,13 +3,52 @@
 #include <string>
 #include <cstdint>
 #include <stdexcept>
+#include <memory>
+#include <chrono>
+#include <span>
+#include "CryptoSession.h"
+#include "KdfPolicy.h"
 
 class CryptoModule {
 public:
-    CryptoModule();
+    // policy only applies to new codebook headers; legacy packed blobs carry no
+    // parameters and always use MODERATE
+    explicit CryptoModule(const KdfPolicy& policy = KdfPolicy::Moderate());
     std::vector<uint8_t> encrypt(const std::string& masterPassword, const std::vector<uint8_t>& plaintext);
     std::vector<uint8_t> decrypt(const std::string& masterPassword, const std::vector<uint8_t>& packedData);
 
+    // Zero-copy variants: salt, nonce and ciphertext are read in place and the
+    // result goes into the caller's buffer, which must hold packedSize() /
+    // plaintextSize() bytes. Both return the number of bytes written; out may
+    // alias the input (in-place encryption/decryption).
+    size_t encrypt(const std::string& masterPassword, std::span<const uint8_t> plaintext, std::span<uint8_t> out);
+    size_t decrypt(const std::string& masterPassword, std::span<const uint8_t> packedData, std::span<uint8_t> out);
+    // Decrypts into arena memory, so the plaintext is wiped with the arena
+    std::span<uint8_t> decrypt(const std::string& masterPassword, std::span<const uint8_t> packedData, SecureArena& arena);
+    static size_t packedSize(size_t plaintextLen);
+    // Throws if packedLen is too short to be a legacy packed blob
+    static size_t plaintextSize(size_t packedLen);
+
+    // Unlock once per codebook/user with the codebook's stored KdfHeader
+    std::unique_ptr<CryptoSession> openSession(const std::string& masterPassword,
+                                               const KdfHeader& header,
+                                               std::chrono::seconds idleTimeout = std::chrono::minutes(5));
+    // Header for a new codebook, using this module's policy
+    KdfHeader createHeader() const;
+    // Policy parameters; an empty salt picks a fresh random one
+    // (read it back via CryptoSession::header() and store it with the codebook).
+    std::unique_ptr<CryptoSession> openSession(const std::string& masterPassword,
+                                               const std::vector<uint8_t>& salt = {},
+                                               std::chrono::seconds idleTimeout = std::chrono::minutes(5));
+
+    // Argon2id at the MODERATE profile all legacy packed blobs are written with
+    static void deriveKey(const char* password, size_t passwordLen, const uint8_t* salt, uint8_t* key);
+    static void deriveKey(const char* password, size_t passwordLen, const KdfHeader& header, uint8_t* key);
+
+    const KdfPolicy& policy() const { return policy_; }
+
 private:
+    KdfPolicy policy_;
+
     void validateSodiumInit() const;
 };
\ No newline at end of file
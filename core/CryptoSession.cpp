@@ -0,0 +1,231 @@
+#include "CryptoSession.h"
+#include "CryptoModule.h"
+#include "Metrics.h"
+#include <sodium.h>
+#include <cstring>
+
+CryptoSession::CryptoSession(const std::string& masterPassword,
+                             const KdfHeader& header,
+                             std::chrono::seconds idleTimeout)
+    : secrets_(2 * crypto_secretbox_KEYBYTES + masterPassword.length() + 1 + 64),
+      key_(nullptr), legacyKey_(nullptr), password_(nullptr), passwordLen_(masterPassword.length()),
+      header_(header), keyId_{}, legacyCompatible_(false),
+      idleTimeout_(idleTimeout), lastUse_(std::chrono::steady_clock::now())
+{
+    if (header_.salt.size() != crypto_pwhash_SALTBYTES) {
+        throw std::invalid_argument("Session salt must be crypto_pwhash_SALTBYTES long");
+    }
+    legacyCompatible_ = header_.kdf_id == crypto_pwhash_ALG_DEFAULT &&
+                        header_.opslimit == crypto_pwhash_OPSLIMIT_MODERATE &&
+                        header_.memlimit == crypto_pwhash_MEMLIMIT_MODERATE;
+
+    // One guarded block holds the key, the legacy scratch key and the password
+    key_ = static_cast<unsigned char*>(secrets_.allocate(crypto_secretbox_KEYBYTES));
+    legacyKey_ = static_cast<unsigned char*>(secrets_.allocate(crypto_secretbox_KEYBYTES));
+    password_ = static_cast<char*>(secrets_.allocate(passwordLen_ + 1, 1));
+    std::memcpy(password_, masterPassword.c_str(), passwordLen_ + 1);
+
+    try {
+        CryptoModule::deriveKey(password_, passwordLen_, header_, key_);
+        static const unsigned char context[] = "mypasswd session key id";
+        crypto_generichash(keyId_.data(), keyId_.size(), context, sizeof context - 1,
+                           key_, crypto_secretbox_KEYBYTES);
+    } catch (...) {
+        lock();
+        throw;
+    }
+}
+
+CryptoSession::~CryptoSession() {
+    lock();
+}
+
+void CryptoSession::lock() {
+    // release() wipes the block before returning it
+    secrets_.release();
+    key_ = nullptr;
+    legacyKey_ = nullptr;
+    password_ = nullptr;
+}
+
+bool CryptoSession::isExpired() const {
+    return std::chrono::steady_clock::now() - lastUse_.load() > idleTimeout_;
+}
+
+const unsigned char* CryptoSession::touchKey() {
+    if (key_ && isExpired()) {
+        lock();
+    }
+    if (!key_) {
+        throw std::runtime_error("Session is locked");
+    }
+    lastUse_.store(std::chrono::steady_clock::now());
+    return key_;
+}
+
+size_t CryptoSession::maxPlaintextSize(size_t packedLen) {
+    // Envelope records have the smaller overhead, so they bound both formats
+    const size_t overhead = VaultEnvelope::recordSize(0);
+    return packedLen < overhead ? 0 : packedLen - overhead;
+}
+
+std::vector<uint8_t> CryptoSession::encrypt(const std::vector<uint8_t>& plaintext) {
+    std::vector<uint8_t> record(recordSize(plaintext.size()));
+    encrypt(plaintext, record);
+    return record;
+}
+
+std::vector<uint8_t> CryptoSession::decrypt(const std::vector<uint8_t>& packedData, bool* isLegacy) {
+    std::vector<uint8_t> plaintext(maxPlaintextSize(packedData.size()));
+    plaintext.resize(decrypt(packedData, plaintext, isLegacy));
+    return plaintext;
+}
+
+bool CryptoSession::decryptRecord(std::span<const uint8_t> record, std::span<uint8_t> out, size_t& written) {
+    Metrics::ScopedTimer timer(Metrics::Op::Decrypt);
+    const unsigned char* key = touchKey();
+    if (!VaultEnvelope::looksLikeRecord(record.data(), record.size())) {
+        return false;
+    }
+    if (out.size() < maxPlaintextSize(record.size())) {
+        throw std::invalid_argument("Output buffer too small");
+    }
+    if (!openRecord(record, key, out, written)) {
+        return false;
+    }
+    Metrics::Add(Metrics::Counter::BytesDecrypted, written);
+    return true;
+}
+
+std::span<uint8_t> CryptoSession::decrypt(std::span<const uint8_t> packedData, SecureArena& arena, bool* isLegacy) {
+    const size_t capacity = maxPlaintextSize(packedData.size());
+    uint8_t* out = static_cast<uint8_t*>(arena.allocate(capacity, 1));
+    size_t written = 0;
+    try {
+        written = decrypt(packedData, std::span<uint8_t>(out, capacity), isLegacy);
+    } catch (...) {
+        arena.deallocate(out, capacity);
+        throw;
+    }
+    // Hand the unused tail back (legacy blobs carry more overhead)
+    arena.deallocate(out + written, capacity - written);
+    return std::span<uint8_t>(out, written);
+}
+
+size_t CryptoSession::encrypt(std::span<const uint8_t> plaintext, std::span<uint8_t> out) {
+    Metrics::ScopedTimer timer(Metrics::Op::Encrypt);
+    const unsigned char* key = touchKey();
+    const size_t total = recordSize(plaintext.size());
+    if (out.size() < total) {
+        throw std::invalid_argument("Output buffer too small");
+    }
+
+    // Nonce is staged locally so out may alias plaintext
+    uint8_t nonce[crypto_secretbox_NONCEBYTES];
+    randombytes_buf(nonce, sizeof nonce);
+
+    uint8_t* ciphertext = out.data() + VaultEnvelope::PREFIX_SIZE + sizeof nonce;
+    if (crypto_secretbox_easy(ciphertext, plaintext.data(), plaintext.size(), nonce, key) != 0) {
+        throw std::runtime_error("Encryption failed");
+    }
+    out[0] = VaultEnvelope::MAGIC;
+    out[1] = VaultEnvelope::VERSION;
+    std::memcpy(out.data() + VaultEnvelope::PREFIX_SIZE, nonce, sizeof nonce);
+    Metrics::Add(Metrics::Counter::BytesEncrypted, plaintext.size());
+    return total;
+}
+
+size_t CryptoSession::decrypt(std::span<const uint8_t> packedData, std::span<uint8_t> out, bool* isLegacy) {
+    Metrics::ScopedTimer timer(Metrics::Op::Decrypt);
+    const unsigned char* key = touchKey();
+    if (out.size() < maxPlaintextSize(packedData.size())) {
+        throw std::invalid_argument("Output buffer too small");
+    }
+
+    // A failed MAC check writes nothing, so an in-place envelope attempt
+    // still leaves the input intact for the legacy fallback
+    size_t written = 0;
+    if (VaultEnvelope::looksLikeRecord(packedData.data(), packedData.size()) &&
+        openRecord(packedData, key, out, written)) {
+        if (isLegacy) {
+            *isLegacy = false;
+        }
+        Metrics::Add(Metrics::Counter::BytesDecrypted, written);
+        return written;
+    }
+
+    // Not an envelope (or a legacy salt that happens to start with the magic)
+    written = openLegacy(packedData, key, out);
+    if (isLegacy) {
+        *isLegacy = true;
+    }
+    Metrics::Add(Metrics::Counter::BytesDecrypted, written);
+    return written;
+}
+
+bool CryptoSession::openRecord(std::span<const uint8_t> packedData, const unsigned char* key,
+                               std::span<uint8_t> out, size_t& written) const {
+    // The nonce is copied first: decrypting in place overwrites it
+    uint8_t nonce[crypto_secretbox_NONCEBYTES];
+    std::memcpy(nonce, packedData.data() + VaultEnvelope::PREFIX_SIZE, sizeof nonce);
+    const uint8_t* ciphertext = packedData.data() + VaultEnvelope::PREFIX_SIZE + sizeof nonce;
+    const size_t ciphertextLen = packedData.size() - VaultEnvelope::PREFIX_SIZE - sizeof nonce;
+
+    written = ciphertextLen - crypto_secretbox_MACBYTES;
+    return crypto_secretbox_open_easy(out.data(), ciphertext, ciphertextLen, nonce, key) == 0;
+}
+
+size_t CryptoSession::openLegacy(std::span<const uint8_t> packedData, const unsigned char* key,
+                                 std::span<uint8_t> out) {
+    const size_t minSize = crypto_pwhash_SALTBYTES + crypto_secretbox_NONCEBYTES + crypto_secretbox_MACBYTES;
+    if (packedData.size() < minSize) {
+        throw std::runtime_error("Invalid packed data format");
+    }
+
+    const uint8_t* blobSalt = packedData.data();
+    uint8_t nonce[crypto_secretbox_NONCEBYTES];
+    std::memcpy(nonce, blobSalt + crypto_pwhash_SALTBYTES, sizeof nonce);
+    const uint8_t* ciphertext = blobSalt + crypto_pwhash_SALTBYTES + sizeof nonce;
+    const size_t ciphertextLen = packedData.size() - crypto_pwhash_SALTBYTES - sizeof nonce;
+
+    // The session key only fits blobs written with the same salt and parameters
+    bool oneOff = !legacyCompatible_ ||
+                  sodium_memcmp(blobSalt, header_.salt.data(), crypto_pwhash_SALTBYTES) != 0;
+    if (!oneOff) {
+        if (crypto_secretbox_open_easy(out.data(), ciphertext, ciphertextLen, nonce, key) != 0) {
+            throw std::runtime_error("Decryption failed: incorrect password or corrupted data");
+        }
+        return ciphertextLen - crypto_secretbox_MACBYTES;
+    }
+
+    // The scratch slot serves one thread at a time; concurrent legacy reads
+    // fall back to their own guarded allocation
+    std::unique_lock<std::mutex> scratch(legacyKeyMutex_, std::try_to_lock);
+    unsigned char* derived = legacyKey_;
+    if (!scratch.owns_lock()) {
+        derived = static_cast<unsigned char*>(sodium_malloc(crypto_secretbox_KEYBYTES));
+        if (!derived) {
+            throw std::runtime_error("Secure memory allocation failed");
+        }
+    }
+    auto wipe = [&] {
+        if (scratch.owns_lock()) {
+            sodium_memzero(derived, crypto_secretbox_KEYBYTES);
+        } else {
+            sodium_free(derived);
+        }
+    };
+
+    try {
+        CryptoModule::deriveKey(password_, passwordLen_, blobSalt, derived);
+    } catch (...) {
+        wipe();
+        throw;
+    }
+    int rc = crypto_secretbox_open_easy(out.data(), ciphertext, ciphertextLen, nonce, derived);
+    wipe();
+    if (rc != 0) {
+        throw std::runtime_error("Decryption failed: incorrect password or corrupted data");
+    }
+    return ciphertextLen - crypto_secretbox_MACBYTES;
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <chrono>
+#include <span>
+#include <stdexcept>
+#include <atomic>
+#include <array>
+#include <mutex>
+#include "VaultEnvelope.h"
+#include "SecureArena.h"
+
+// Unlocked vault key. The key derivation runs once when the session is
+// opened from the codebook's KdfHeader; every encrypt/decrypt afterwards is a
+// single crypto_secretbox call. Key material lives in one SecureArena block
+// (guarded, mlock'd) and is wiped on lock(), on destruction, or after
+// idleTimeout without use. encrypt/decrypt may run on several threads at once;
+// lock() must not race with calls still in flight.
+class CryptoSession {
+public:
+    CryptoSession(const std::string& masterPassword,
+                  const KdfHeader& header,
+                  std::chrono::seconds idleTimeout);
+    ~CryptoSession();
+
+    CryptoSession(const CryptoSession&) = delete;
+    CryptoSession& operator=(const CryptoSession&) = delete;
+
+    // Writes a VaultEnvelope entry record (no per-entry salt)
+    std::vector<uint8_t> encrypt(const std::vector<uint8_t>& plaintext);
+    // Accepts envelope records and legacy salt || nonce || ciphertext blobs.
+    // Legacy blobs with a foreign salt fall back to a one-off key derivation;
+    // isLegacy tells the caller the blob is worth rewriting.
+    std::vector<uint8_t> decrypt(const std::vector<uint8_t>& packedData, bool* isLegacy = nullptr);
+
+    // Zero-copy variants for bulk paths: the input is read in place (e.g. a
+    // span over sqlite3_column_blob) and the result goes into out, which must
+    // hold recordSize() / maxPlaintextSize() bytes. Both return the number of
+    // bytes written; out may alias the input.
+    size_t encrypt(std::span<const uint8_t> plaintext, std::span<uint8_t> out);
+    size_t decrypt(std::span<const uint8_t> packedData, std::span<uint8_t> out, bool* isLegacy = nullptr);
+    static size_t recordSize(size_t plaintextLen) { return VaultEnvelope::recordSize(plaintextLen); }
+    // Upper bound over both formats; 0 if packedLen cannot be a valid blob
+    static size_t maxPlaintextSize(size_t packedLen);
+    // Envelope records only: never derives a key, so a blob written under a
+    // different key just returns false (used to skip already-rotated rows)
+    bool decryptRecord(std::span<const uint8_t> record, std::span<uint8_t> out, size_t& written);
+    // Decrypts into arena memory, so the plaintext is wiped with the arena
+    std::span<uint8_t> decrypt(std::span<const uint8_t> packedData, SecureArena& arena, bool* isLegacy = nullptr);
+
+    // Keyed hash of the session key over a fixed context: equal ids mean the
+    // same key, without revealing it. Lets caches bind entries to a key
+    static constexpr size_t KEY_ID_SIZE = 32;
+    const std::array<uint8_t, KEY_ID_SIZE>& keyId() const { return keyId_; }
+
+    const KdfHeader& header() const { return header_; }
+    const std::vector<uint8_t>& salt() const { return header_.salt; }
+    bool isLocked() const { return key_ == nullptr; }
+    bool isExpired() const;
+    void lock();
+
+private:
+    SecureArena secrets_;
+    unsigned char* key_;
+    unsigned char* legacyKey_;   // scratch for one-off legacy derivations
+    std::mutex legacyKeyMutex_;
+    char* password_;   // kept only to open legacy blobs with their own salt
+    size_t passwordLen_;
+    KdfHeader header_;
+    std::array<uint8_t, KEY_ID_SIZE> keyId_;
+    bool legacyCompatible_;   // header matches CryptoModule::encrypt parameters
+    std::chrono::seconds idleTimeout_;
+    std::atomic<std::chrono::steady_clock::time_point> lastUse_;
+
+    const unsigned char* touchKey();
+    bool openRecord(std::span<const uint8_t> packedData, const unsigned char* key,
+                    std::span<uint8_t> out, size_t& written) const;
+    size_t openLegacy(std::span<const uint8_t> packedData, const unsigned char* key, std::span<uint8_t> out);
+};
\ No newline at end of file
@@ -0,0 +1,235 @@
+#include "Database.h"
+
+using namespace std;
+
+void WriterQueue::lock() {
+    unique_lock<mutex> lock(mutex_);
+    if (depth_ > 0 && owner_ == this_thread::get_id()) {
+        ++depth_;
+        return;
+    }
+
+    uint64_t ticket = next_ticket_++;
+    turn_.wait(lock, [this, ticket] { return depth_ == 0 && now_serving_ == ticket; });
+    owner_ = this_thread::get_id();
+    depth_ = 1;
+}
+
+void WriterQueue::unlock() {
+    unique_lock<mutex> lock(mutex_);
+    if (--depth_ > 0) {
+        return;
+    }
+    owner_ = thread::id();
+    ++now_serving_;
+    lock.unlock();
+    turn_.notify_all();
+}
+
+Statement::Statement(sqlite3_stmt* stmt, bool* in_use)
+    : stmt_(stmt), in_use_(in_use), start_ns_(Metrics::Enabled() ? Metrics::Now() : 0) {}
+
+Statement::Statement(Statement&& other) noexcept
+    : stmt_(other.stmt_), in_use_(other.in_use_), start_ns_(other.start_ns_) {
+    other.stmt_ = nullptr;
+    other.in_use_ = nullptr;
+}
+
+Statement::~Statement() {
+    if (!stmt_) {
+        return;
+    }
+    if (start_ns_ != 0) {
+        Metrics::Global().RecordQuery(sqlite3_sql(stmt_), Metrics::Now() - start_ns_);
+    }
+    if (!in_use_) {
+        sqlite3_finalize(stmt_);
+        return;
+    }
+    sqlite3_reset(stmt_);
+    sqlite3_clear_bindings(stmt_);
+    *in_use_ = false;
+}
+
+Database::Database(const string& path, int flags) : db_(nullptr), owned_(true) {
+    if (sqlite3_open_v2(path.c_str(), &db_, flags, nullptr) != SQLITE_OK) {
+        string error = db_ ? sqlite3_errmsg(db_) : "out of memory";
+        sqlite3_close_v2(db_);
+        throw runtime_error("Database open failed: " + error);
+    }
+    try {
+        EnableForeignKeys();
+    } catch (...) {
+        sqlite3_close_v2(db_);
+        throw;
+    }
+}
+
+Database::Database(sqlite3* handle) : db_(handle), owned_(false) {
+    if (!db_) {
+        throw invalid_argument("Invalid database connection");
+    }
+    EnableForeignKeys();
+}
+
+void Database::EnableForeignKeys() {
+    // 事务内设置无效，因此在连接打开时立即执行
+    if (sqlite3_exec(db_, "PRAGMA foreign_keys = ON", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        throw runtime_error("Failed to enable foreign keys: " + string(sqlite3_errmsg(db_)));
+    }
+}
+
+WriteStatus Database::StatusOf(int rc) const {
+    if (rc == SQLITE_DONE || rc == SQLITE_ROW) {
+        return WriteStatus::Ok;
+    }
+    if ((rc & 0xFF) != SQLITE_CONSTRAINT) {
+        return WriteStatus::Error;
+    }
+    switch (sqlite3_extended_errcode(db_)) {
+    case SQLITE_CONSTRAINT_FOREIGNKEY:
+        return WriteStatus::NotFound;
+    case SQLITE_CONSTRAINT_PRIMARYKEY:
+    case SQLITE_CONSTRAINT_UNIQUE:
+        return WriteStatus::AlreadyExists;
+    default:
+        return WriteStatus::ConstraintFailed;
+    }
+}
+
+Database::~Database() {
+    for (auto& item : statements_) {
+        sqlite3_finalize(item.second.stmt);
+    }
+    statements_.clear();
+
+    if (owned_ && db_) {
+        sqlite3_close_v2(db_);
+    }
+}
+
+void Database::Configure(const StorageProfile& profile, bool read_only) {
+    // 两个字符串参数会拼进 PRAGMA，只接受白名单取值
+    static const char* const journal_modes[] = {"DELETE", "TRUNCATE", "PERSIST", "MEMORY", "WAL", "OFF"};
+    static const char* const sync_modes[] = {"OFF", "NORMAL", "FULL", "EXTRA"};
+    auto allowed = [](const string& value, const auto& options) {
+        for (const char* option : options) {
+            if (value == option) {
+                return true;
+            }
+        }
+        return false;
+    };
+    if (!allowed(profile.journal_mode, journal_modes) || !allowed(profile.synchronous, sync_modes)) {
+        throw invalid_argument("Invalid storage profile");
+    }
+
+    string sql;
+    if (!read_only) {
+        sql += "PRAGMA journal_mode = " + profile.journal_mode + ";";
+        sql += "PRAGMA synchronous = " + profile.synchronous + ";";
+    }
+    sql += "PRAGMA mmap_size = " + to_string(profile.mmap_size) + ";";
+    sql += "PRAGMA cache_size = " + to_string(-static_cast<int64_t>(profile.cache_size_kib)) + ";";
+
+    char* errMsg = nullptr;
+    if (sqlite3_exec(db_, sql.c_str(), nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        string error = errMsg ? errMsg : "Unknown error";
+        sqlite3_free(errMsg);
+        throw runtime_error("Configure failed: " + error);
+    }
+    sqlite3_busy_timeout(db_, profile.busy_timeout_ms);
+}
+
+Statement Database::Prepare(const char* sql) {
+    auto it = statements_.find(sql);
+    if (it != statements_.end() && !it->second.in_use) {
+        Metrics::Add(Metrics::Counter::StatementCacheHits);
+        it->second.in_use = true;
+        return Statement(it->second.stmt, &it->second.in_use);
+    }
+
+    sqlite3_stmt* stmt;
+    {
+        Metrics::ScopedTimer timer(Metrics::Op::SqlPrepare);
+        Metrics::Add(Metrics::Counter::StatementsPrepared);
+        if (sqlite3_prepare_v3(db_, sql, -1, SQLITE_PREPARE_PERSISTENT, &stmt, nullptr) != SQLITE_OK) {
+            throw runtime_error("Prepare failed: " + string(sqlite3_errmsg(db_)));
+        }
+    }
+
+    if (it != statements_.end()) {
+        return Statement(stmt, nullptr);
+    }
+
+    // unordered_map 的节点地址在 rehash 时保持不变，可安全持有 in_use 指针
+    auto inserted = statements_.emplace(sql, CachedStatement{stmt, true}).first;
+    return Statement(stmt, &inserted->second.in_use);
+}
+
+bool Database::BeginTransaction() {
+    writer_.lock();
+    bool success;
+    {
+        Statement stmt = Prepare("BEGIN TRANSACTION");
+        success = sqlite3_step(stmt) == SQLITE_DONE;
+    }
+    if (!success) {
+        writer_.unlock();
+        return false;
+    }
+    transaction_held_ = true;
+    return true;
+}
+
+bool Database::CommitTransaction() {
+    bool success;
+    {
+        Metrics::ScopedTimer timer(Metrics::Op::SqlCommit);
+        Statement stmt = Prepare("COMMIT");
+        success = sqlite3_step(stmt) == SQLITE_DONE;
+    }
+    vector<function<void()>> actions;
+    if (sqlite3_get_autocommit(db_)) {
+        actions.swap(after_commit_);
+    }
+    // 提交失败但事务仍在时保留写锁，等待调用方回滚
+    ReleaseTransactionIfFinished();
+    if (success) {
+        for (function<void()>& action : actions) {
+            action();
+        }
+    }
+    return success;
+}
+
+bool Database::RollbackTransaction() {
+    bool success = true;
+    if (!sqlite3_get_autocommit(db_)) {
+        Statement stmt = Prepare("ROLLBACK");
+        success = sqlite3_step(stmt) == SQLITE_DONE;
+    }
+    if (sqlite3_get_autocommit(db_)) {
+        after_commit_.clear();
+    }
+    ReleaseTransactionIfFinished();
+    return success;
+}
+
+void Database::AfterCommit(function<void()> action) {
+    {
+        auto lock = Lock();
+        if (!sqlite3_get_autocommit(db_)) {
+            after_commit_.push_back(move(action));
+            return;
+        }
+    }
+    action();
+}
+
+void Database::ReleaseTransactionIfFinished() {
+    if (transaction_held_ && sqlite3_get_autocommit(db_)) {
+        transaction_held_ = false;
+        writer_.unlock();
+    }
+}
\ No newline at end of file
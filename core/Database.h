@@ -0,0 +1,134 @@
+#pragma once
+#include <sqlite3.h>
+#include <string>
+#include <unordered_map>
+#include <stdexcept>
+#include <cstdint>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+#include <vector>
+#include "Metrics.h"
+
+class Database;
+
+// 单写者队列：可重入的 FIFO 锁。同一线程可嵌套获取，其它线程按到达顺序排队，
+// 长批量写入不会让后到的写请求饿死
+class WriterQueue {
+public:
+    void lock();
+    void unlock();
+
+private:
+    std::mutex mutex_;
+    std::condition_variable turn_;
+    std::thread::id owner_;
+    int depth_ = 0;
+    uint64_t next_ticket_ = 0;
+    uint64_t now_serving_ = 0;
+};
+
+// 连接调优参数，打开连接后立即生效
+struct StorageProfile {
+    std::string journal_mode = "WAL";     // WAL 下读写互不阻塞
+    std::string synchronous = "NORMAL";   // WAL + NORMAL 只在检查点时 fsync
+    int64_t mmap_size = 256LL * 1024 * 1024;
+    int cache_size_kib = 16 * 1024;
+    int busy_timeout_ms = 5000;
+    int read_pool_size = 4;               // 0 表示所有读都走写连接
+};
+
+// 写操作结果：约束错误映射为可区分的状态，explicit bool 保留 if (vault.AddEntry(...)) 的写法
+enum class WriteStatus {
+    Ok,
+    NotFound,           // 目标行或外键引用的父行不存在
+    AlreadyExists,      // 主键/唯一约束冲突
+    ConstraintFailed,   // CHECK、NOT NULL 等其它约束
+    Error
+};
+
+struct WriteResult {
+    WriteStatus status = WriteStatus::Error;
+    int64_t id = 0;   // INSERT ... RETURNING 得到的新行 id，其它情况为 0
+
+    explicit operator bool() const { return status == WriteStatus::Ok; }
+};
+
+// 缓存语句的租用句柄，析构时 reset 并清空绑定，语句本身留在缓存中复用。
+// 启用 Metrics 时租用期间的耗时记为一次 sql_query
+class Statement {
+public:
+    Statement(Statement&& other) noexcept;
+    Statement& operator=(Statement&&) = delete;
+    Statement(const Statement&) = delete;
+    Statement& operator=(const Statement&) = delete;
+    ~Statement();
+
+    sqlite3_stmt* get() const { return stmt_; }
+    operator sqlite3_stmt*() const { return stmt_; }
+
+private:
+    friend class Database;
+    Statement(sqlite3_stmt* stmt, bool* in_use);
+
+    sqlite3_stmt* stmt_;
+    bool* in_use_;   // 为空表示一次性语句，析构时直接 finalize
+    uint64_t start_ns_;   // 0 表示未计时
+};
+
+// 数据库连接及其预编译语句缓存：每条 SQL 只 prepare 一次，连接销毁时统一 finalize。
+// 每个连接（包括包装的外部连接）打开时即启用外键约束，级联删除依赖于此
+class Database {
+public:
+    // 打开并持有连接
+    Database(const std::string& path, int flags);
+    // 包装外部连接，不负责关闭
+    explicit Database(sqlite3* handle);
+    ~Database();
+
+    Database(const Database&) = delete;
+    Database& operator=(const Database&) = delete;
+
+    sqlite3* Handle() const { return db_; }
+
+    // 应用调优参数；只读连接跳过 journal_mode（由写连接决定）
+    void Configure(const StorageProfile& profile, bool read_only = false);
+
+    // 取得缓存语句；同一 SQL 正被占用时（如嵌套调用）退化为一次性语句。
+    // 多线程共享的连接须先持有 Lock()
+    Statement Prepare(const char* sql);
+
+    std::unique_lock<WriterQueue> Lock() { return std::unique_lock<WriterQueue>(writer_); }
+
+    // 把 sqlite3_step 的返回码（结合扩展错误码）映射为 WriteStatus
+    WriteStatus StatusOf(int rc) const;
+
+    // 事务从 Begin 到 Commit/Rollback 全程持有写锁，因此事务只属于开启它的线程。
+    // RollbackTransaction 可在任何失败路径上无条件调用
+    bool BeginTransaction();
+    bool CommitTransaction();
+    bool RollbackTransaction();
+
+    // 当前事务提交后执行 action（在提交线程上、释放事务写锁后），回滚则丢弃；
+    // 不在事务中时立即执行。其它线程的事务进行中时等待其结束。
+    // 缓存失效经此延后，读者才不会在提交前把旧行放回缓存。
+    // 外层事务须经 BeginTransaction/CommitTransaction 开启
+    void AfterCommit(std::function<void()> action);
+
+private:
+    struct CachedStatement {
+        sqlite3_stmt* stmt;
+        bool in_use;
+    };
+
+    sqlite3* db_;
+    bool owned_;
+    std::unordered_map<std::string, CachedStatement> statements_;
+    WriterQueue writer_;
+    bool transaction_held_ = false;   // 仅由持锁线程读写
+    std::vector<std::function<void()>> after_commit_;   // 同上
+
+    void ReleaseTransactionIfFinished();
+    void EnableForeignKeys();
+};
\ No newline at end of file
@@ -0,0 +1,21 @@
+#include "DecryptedPage.h"
+#include <utility>
+
+DecryptedPage::DecryptedPage(size_t arenaBlockSize) : arena_(arenaBlockSize) {}
+
+bool DecryptedPage::add(CryptoSession& session, PasswordVault::PasswordEntry entry) {
+    std::span<const uint8_t> blob(reinterpret_cast<const uint8_t*>(entry.encrypted_password.data()),
+                                  entry.encrypted_password.size());
+    bool isLegacy = false;
+    std::span<uint8_t> password = session.decrypt(blob, arena_, &isLegacy);
+
+    entry.encrypted_password.clear();
+    entry.encrypted_password.shrink_to_fit();
+    items_.push_back(Item{std::move(entry), password});
+    return isLegacy;
+}
+
+void DecryptedPage::clear() noexcept {
+    items_.clear();
+    arena_.reset();
+}
\ No newline at end of file
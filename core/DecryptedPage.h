@@ -0,0 +1,42 @@
+#pragma once
+#include <vector>
+#include <string_view>
+#include <span>
+#include <cstdint>
+#include "SecureArena.h"
+#include "CryptoSession.h"
+#include "PassWordVault.h"
+
+// One page of entries with their passwords decrypted into a single
+// SecureArena. Metadata stays in ordinary memory; every plaintext lives in the
+// arena and clear() (or destruction) wipes the whole page in one pass.
+class DecryptedPage {
+public:
+    struct Item {
+        PasswordVault::PasswordEntry entry;   // encrypted_password is dropped once decrypted
+        std::span<const uint8_t> password;    // valid until clear()
+
+        std::string_view passwordText() const {
+            return std::string_view(reinterpret_cast<const char*>(password.data()), password.size());
+        }
+    };
+
+    explicit DecryptedPage(size_t arenaBlockSize = SecureArena::DEFAULT_BLOCK_SIZE);
+
+    DecryptedPage(const DecryptedPage&) = delete;
+    DecryptedPage& operator=(const DecryptedPage&) = delete;
+
+    // Decrypts entry.encrypted_password and appends it; returns whether the
+    // blob was in the legacy format (worth rewriting)
+    bool add(CryptoSession& session, PasswordVault::PasswordEntry entry);
+
+    const std::vector<Item>& items() const { return items_; }
+    size_t size() const { return items_.size(); }
+    bool empty() const { return items_.empty(); }
+
+    void clear() noexcept;
+
+private:
+    SecureArena arena_;
+    std::vector<Item> items_;
+};
\ No newline at end of file
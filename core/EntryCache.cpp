@@ -0,0 +1,247 @@
+#include "EntryCache.h"
+#include <sodium.h>
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+using namespace std;
+
+EntryCache::EntryCache(const Options& options) : options_(options) {
+    size_t slots = options_.max_secret_bytes / SECRET_SLOT_SIZE;
+    if (slots == 0) {
+        return;
+    }
+    slab_ = static_cast<unsigned char*>(sodium_malloc(slots * SECRET_SLOT_SIZE));
+    if (!slab_) {
+        throw bad_alloc();
+    }
+    free_slots_.reserve(slots);
+    for (size_t i = slots; i > 0; --i) {
+        free_slots_.push_back(i - 1);
+    }
+}
+
+EntryCache::~EntryCache() {
+    // sodium_free 会先擦除整块
+    if (slab_) {
+        sodium_free(slab_);
+    }
+}
+
+uint64_t EntryCache::Generation() const {
+    lock_guard<mutex> lock(mutex_);
+    return generation_;
+}
+
+void EntryCache::PutEntry(int codebook_id, const PasswordVault::PasswordEntry& entry, uint64_t generation) {
+    size_t bytes = sizeof(EntryNode) + entry.address.size() + entry.public_key.size() +
+                   entry.encrypted_password.size() + entry.notes.size() + entry.created_time.size();
+    if (bytes > options_.max_entry_bytes) {
+        return;
+    }
+
+    lock_guard<mutex> lock(mutex_);
+    if (generation != generation_) {
+        return;
+    }
+    Clock::time_point now = Clock::now();
+    PurgeExpiredLocked(now, false);
+
+    auto existing = entries_.find(entry.id);
+    if (existing != entries_.end()) {
+        EraseEntry(existing->second);
+    }
+    while (!entry_lru_.empty() && entry_bytes_ + bytes > options_.max_entry_bytes) {
+        EraseEntry(prev(entry_lru_.end()));
+        ++evictions_;
+    }
+    entry_lru_.push_front(EntryNode{codebook_id, entry, bytes, now + options_.ttl});
+    entries_[entry.id] = entry_lru_.begin();
+    entry_bytes_ += bytes;
+}
+
+bool EntryCache::GetEntry(int entry_id, PasswordVault::PasswordEntry& entry) {
+    lock_guard<mutex> lock(mutex_);
+    auto it = entries_.find(entry_id);
+    if (it == entries_.end()) {
+        ++misses_;
+        return false;
+    }
+    if (it->second->expires <= Clock::now()) {
+        EraseEntry(it->second);
+        ++expirations_;
+        ++misses_;
+        return false;
+    }
+    entry_lru_.splice(entry_lru_.begin(), entry_lru_, it->second);
+    entry = it->second->entry;
+    ++hits_;
+    return true;
+}
+
+EntryCache::Check EntryCache::CheckOf(const CryptoSession& session, span<const uint8_t> ciphertext) {
+    Check check;
+    crypto_generichash(check.data(), check.size(), ciphertext.data(), ciphertext.size(),
+                       session.keyId().data(), session.keyId().size());
+    return check;
+}
+
+span<uint8_t> EntryCache::Reveal(int codebook_id,
+                                 const PasswordVault::PasswordEntry& entry,
+                                 CryptoSession& session,
+                                 SecureArena& arena,
+                                 bool* isLegacy)
+{
+    if (session.isLocked() || session.isExpired()) {
+        throw runtime_error("Session is locked");
+    }
+    span<const uint8_t> blob(reinterpret_cast<const uint8_t*>(entry.encrypted_password.data()),
+                             entry.encrypted_password.size());
+    Check check = CheckOf(session, blob);
+
+    {
+        lock_guard<mutex> lock(mutex_);
+        auto it = secrets_.find(entry.id);
+        if (it != secrets_.end()) {
+            SecretNode& node = *it->second;
+            if (node.expires <= Clock::now()) {
+                EraseSecret(it->second);
+                ++expirations_;
+            } else if (node.codebook_id == codebook_id &&
+                       sodium_memcmp(node.check.data(), check.data(), check.size()) == 0) {
+                uint8_t* out = static_cast<uint8_t*>(arena.allocate(node.size, 1));
+                memcpy(out, slab_ + node.slot * SECRET_SLOT_SIZE, node.size);
+                secret_lru_.splice(secret_lru_.begin(), secret_lru_, it->second);
+                ++hits_;
+                if (isLegacy) {
+                    *isLegacy = node.legacy;
+                }
+                return span<uint8_t>(out, node.size);
+            }
+        }
+        ++misses_;
+    }
+
+    // 解密在锁外进行；旧格式条目可能要跑一次 KDF
+    bool legacy = false;
+    span<uint8_t> plaintext = session.decrypt(blob, arena, &legacy);
+    PutSecret(codebook_id, entry.id, check, legacy, plaintext);
+    if (isLegacy) {
+        *isLegacy = legacy;
+    }
+    return plaintext;
+}
+
+void EntryCache::PutSecret(int codebook_id, int entry_id, const Check& check, bool legacy,
+                           span<const uint8_t> plaintext) {
+    if (!slab_ || plaintext.size() > SECRET_SLOT_SIZE) {
+        return;
+    }
+
+    lock_guard<mutex> lock(mutex_);
+    Clock::time_point now = Clock::now();
+    PurgeExpiredLocked(now, false);
+
+    auto existing = secrets_.find(entry_id);
+    if (existing != secrets_.end()) {
+        EraseSecret(existing->second);
+    }
+    if (free_slots_.empty()) {
+        EraseSecret(prev(secret_lru_.end()));
+        ++evictions_;
+    }
+    size_t slot = free_slots_.back();
+    free_slots_.pop_back();
+    memcpy(slab_ + slot * SECRET_SLOT_SIZE, plaintext.data(), plaintext.size());
+
+    secret_lru_.push_front(SecretNode{entry_id, codebook_id, slot, plaintext.size(), check, legacy, now + options_.ttl});
+    secrets_[entry_id] = secret_lru_.begin();
+}
+
+void EntryCache::InvalidateEntry(int entry_id) {
+    lock_guard<mutex> lock(mutex_);
+    ++generation_;
+    auto entry = entries_.find(entry_id);
+    if (entry != entries_.end()) {
+        EraseEntry(entry->second);
+    }
+    auto secret = secrets_.find(entry_id);
+    if (secret != secrets_.end()) {
+        EraseSecret(secret->second);
+    }
+}
+
+void EntryCache::InvalidateCodebook(int codebook_id) {
+    lock_guard<mutex> lock(mutex_);
+    ++generation_;
+    for (auto it = entry_lru_.begin(); it != entry_lru_.end();) {
+        auto current = it++;
+        if (current->codebook_id == codebook_id) {
+            EraseEntry(current);
+        }
+    }
+    for (auto it = secret_lru_.begin(); it != secret_lru_.end();) {
+        auto current = it++;
+        if (current->codebook_id == codebook_id) {
+            EraseSecret(current);
+        }
+    }
+}
+
+void EntryCache::Clear() {
+    lock_guard<mutex> lock(mutex_);
+    ++generation_;
+    while (!entry_lru_.empty()) {
+        EraseEntry(entry_lru_.begin());
+    }
+    while (!secret_lru_.empty()) {
+        EraseSecret(secret_lru_.begin());
+    }
+}
+
+void EntryCache::PurgeExpired() {
+    lock_guard<mutex> lock(mutex_);
+    PurgeExpiredLocked(Clock::now(), true);
+}
+
+EntryCache::Stats EntryCache::GetStats() const {
+    lock_guard<mutex> lock(mutex_);
+    return {hits_, misses_, evictions_, expirations_, entry_bytes_, entries_.size(), secrets_.size()};
+}
+
+void EntryCache::EraseEntry(list<EntryNode>::iterator it) {
+    entry_bytes_ -= it->bytes;
+    entries_.erase(it->entry.id);
+    entry_lru_.erase(it);
+}
+
+void EntryCache::EraseSecret(list<SecretNode>::iterator it) {
+    sodium_memzero(slab_ + it->slot * SECRET_SLOT_SIZE, it->size);
+    free_slots_.push_back(it->slot);
+    secrets_.erase(it->entry_id);
+    secret_lru_.erase(it);
+}
+
+void EntryCache::PurgeExpiredLocked(Clock::time_point now, bool force) {
+    // TTL 不随访问续期，过期项可能在 LRU 任意位置，只能整表扫描；
+    // Put 路径上每 1/8 个 TTL 扫一次，过期明文最多多留这么久
+    if (!force && now < next_purge_) {
+        return;
+    }
+    next_purge_ = now + max<Clock::duration>(options_.ttl / 8, chrono::seconds(1));
+    for (auto it = entry_lru_.begin(); it != entry_lru_.end();) {
+        auto current = it++;
+        if (current->expires <= now) {
+            EraseEntry(current);
+            ++expirations_;
+        }
+    }
+    for (auto it = secret_lru_.begin(); it != secret_lru_.end();) {
+        auto current = it++;
+        if (current->expires <= now) {
+            EraseSecret(current);
+            ++expirations_;
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,120 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+#include <vector>
+#include "PassWordVault.h"
+#include "CryptoSession.h"
+#include "SecureArena.h"
+
+// 条目缓存：按 (codebook_id, entry_id) 缓存条目元数据与解密后的明文，各自 LRU 淘汰，
+// 均有 TTL（自写入起计，访问不续期）。
+//  - 元数据在普通内存中，受 max_entry_bytes 限制；
+//  - 明文放在一块 sodium_malloc 的定长槽位区（加锁内存、带保护页），槽位释放或过期时立即擦除；
+//    超过 SECRET_SLOT_SIZE 的明文不缓存。
+// 明文命中要求会话的 keyId 与密文都与写入时一致，因此换钥、密文改写或用错误口令打开的会话
+// 都不会命中。PasswordVault::SetEntryCache 后的更新、删除与删密码本会主动失效对应条目。
+// 线程安全
+class EntryCache {
+public:
+    static constexpr size_t SECRET_SLOT_SIZE = 256;
+
+    struct Options {
+        size_t max_entry_bytes = 4 * 1024 * 1024;
+        size_t max_secret_bytes = 64 * 1024;   // 向下取整到槽位大小，0 表示不缓存明文
+        std::chrono::seconds ttl{300};
+    };
+
+    struct Stats {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions;
+        uint64_t expirations;
+        size_t entry_bytes;
+        size_t entries;
+        size_t secrets;
+    };
+
+    explicit EntryCache(const Options& options);
+    EntryCache() : EntryCache(Options()) {}
+    ~EntryCache();
+
+    EntryCache(const EntryCache&) = delete;
+    EntryCache& operator=(const EntryCache&) = delete;
+
+    // 失效时递增。读库前取得的 generation 传给 PutEntry，期间发生过失效则丢弃这次写入，
+    // 避免并发更新后把旧行放回缓存
+    uint64_t Generation() const;
+
+    void PutEntry(int codebook_id, const PasswordVault::PasswordEntry& entry, uint64_t generation);
+    bool GetEntry(int entry_id, PasswordVault::PasswordEntry& entry);
+
+    // 先查明文缓存，命中时复制到 arena；否则用会话解密 entry.encrypted_password 并回填。
+    // 会话已锁定或超时时抛出异常，不返回缓存明文
+    std::span<uint8_t> Reveal(int codebook_id,
+                              const PasswordVault::PasswordEntry& entry,
+                              CryptoSession& session,
+                              SecureArena& arena,
+                              bool* isLegacy = nullptr);
+
+    void InvalidateEntry(int entry_id);
+    void InvalidateCodebook(int codebook_id);
+    void Clear();
+    // 立即擦除所有过期项；Put 时也会定期顺带执行
+    void PurgeExpired();
+
+    Stats GetStats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+    using Check = std::array<uint8_t, 16>;
+
+    struct EntryNode {
+        int codebook_id;
+        PasswordVault::PasswordEntry entry;
+        size_t bytes;
+        Clock::time_point expires;
+    };
+
+    struct SecretNode {
+        int entry_id;
+        int codebook_id;
+        size_t slot;
+        size_t size;
+        Check check;   // 以会话 keyId 为密钥对密文做的 BLAKE2b
+        bool legacy;
+        Clock::time_point expires;
+    };
+
+    Options options_;
+    mutable std::mutex mutex_;
+    uint64_t generation_ = 0;
+    Clock::time_point next_purge_{};
+
+    std::list<EntryNode> entry_lru_;   // 头部最近使用
+    std::unordered_map<int, std::list<EntryNode>::iterator> entries_;
+    size_t entry_bytes_ = 0;
+
+    unsigned char* slab_ = nullptr;
+    std::vector<size_t> free_slots_;
+    std::list<SecretNode> secret_lru_;
+    std::unordered_map<int, std::list<SecretNode>::iterator> secrets_;
+
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+    uint64_t evictions_ = 0;
+    uint64_t expirations_ = 0;
+
+    static Check CheckOf(const CryptoSession& session, std::span<const uint8_t> ciphertext);
+
+    void EraseEntry(std::list<EntryNode>::iterator it);
+    void EraseSecret(std::list<SecretNode>::iterator it);
+    void PutSecret(int codebook_id, int entry_id, const Check& check, bool legacy,
+                   std::span<const uint8_t> plaintext);
+    void PurgeExpiredLocked(Clock::time_point now, bool force);
+};
\ No newline at end of file
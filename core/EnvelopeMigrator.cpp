@@ -0,0 +1,54 @@
+#include "EnvelopeMigrator.h"
+#include <stdexcept>
+
+EnvelopeMigrator::EnvelopeMigrator(PasswordVault& vault, CryptoModule& crypto)
+    : vault_(vault), crypto_(crypto) {}
+
+std::unique_ptr<CryptoSession> EnvelopeMigrator::unlock(int codebook_id,
+                                                        const std::string& masterPassword,
+                                                        std::chrono::seconds idleTimeout) {
+    std::vector<uint8_t> stored;
+    if (!vault_.GetKdfHeader(codebook_id, stored)) {
+        // First unlock of this codebook. SetKdfHeader keeps an existing header,
+        // so if another caller won the race both sessions still share one key.
+        vault_.SetKdfHeader(codebook_id, crypto_.createHeader().serialize());
+        if (!vault_.GetKdfHeader(codebook_id, stored)) {
+            throw std::runtime_error("Codebook does not exist");
+        }
+    }
+    return crypto_.openSession(masterPassword, KdfHeader::parse(stored), idleTimeout);
+}
+
+std::vector<uint8_t> EnvelopeMigrator::reveal(CryptoSession& session, int entry_id) {
+    std::vector<uint8_t> blob;
+    if (!vault_.GetEncryptedPassword(entry_id, blob)) {
+        throw std::runtime_error("Entry does not exist");
+    }
+
+    bool isLegacy = false;
+    std::vector<uint8_t> plaintext = session.decrypt(blob, &isLegacy);
+    if (isLegacy) {
+        vault_.UpdateEncryptedPassword(entry_id, session.encrypt(plaintext));
+    }
+    return plaintext;
+}
+
+size_t EnvelopeMigrator::revealPage(CryptoSession& session, int codebook_id,
+                                    const std::string& cursor, std::string& next_cursor,
+                                    DecryptedPage& page, int page_size) {
+    page.clear();
+    size_t rewritten = 0;
+    std::vector<uint8_t> record;
+    for (PasswordVault::PasswordEntry& entry : vault_.GetEntriesAfter(codebook_id, cursor, next_cursor, page_size)) {
+        if (!page.add(session, std::move(entry))) {
+            continue;
+        }
+        const DecryptedPage::Item& item = page.items().back();
+        record.resize(CryptoSession::recordSize(item.password.size()));
+        session.encrypt(item.password, record);
+        if (vault_.UpdateEncryptedPassword(item.entry.id, record)) {
+            ++rewritten;
+        }
+    }
+    return rewritten;
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <memory>
+#include <chrono>
+#include "CryptoModule.h"
+#include "PassWordVault.h"
+#include "DecryptedPage.h"
+
+// Idle timeout for sessions that live for a whole batch job (rotation, audit);
+// the caller's idle policy does not apply
+inline constexpr std::chrono::seconds kJobSessionTimeout = std::chrono::hours(24);
+
+// Lazily moves a codebook from per-entry salts (CryptoModule::encrypt output)
+// to the VaultEnvelope format. unlock() derives the codebook key once from its
+// stored KdfHeader (creating one on first use); reveal() rewrites a legacy
+// entry as an envelope record the first time it is read, so later reads of an
+// N-entry codebook cost one key derivation instead of N.
+class EnvelopeMigrator {
+public:
+    EnvelopeMigrator(PasswordVault& vault, CryptoModule& crypto);
+
+    std::unique_ptr<CryptoSession> unlock(int codebook_id,
+                                          const std::string& masterPassword,
+                                          std::chrono::seconds idleTimeout = std::chrono::minutes(5));
+
+    std::vector<uint8_t> reveal(CryptoSession& session, int entry_id);
+    // Decrypts one GetEntriesAfter page into page (cleared first), rewriting
+    // legacy entries as it goes; returns the number of entries rewritten
+    size_t revealPage(CryptoSession& session, int codebook_id,
+                      const std::string& cursor, std::string& next_cursor,
+                      DecryptedPage& page, int page_size = 50);
+
+private:
+    PasswordVault& vault_;
+    CryptoModule& crypto_;
+};
\ No newline at end of file
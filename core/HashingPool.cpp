@@ -0,0 +1,125 @@
+#include "HashingPool.h"
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+HashingPool::HashingPool(size_t memlimit_per_task, size_t max_workers, size_t max_queue)
+    : max_queue_(max_queue)
+{
+    if (memlimit_per_task == 0 || max_queue == 0) {
+        throw invalid_argument("Invalid hashing pool limits");
+    }
+
+    size_t cores = max(1u, thread::hardware_concurrency());
+    size_t limit = max_workers ? max_workers : cores;
+    // 只使用一半空闲内存，给 SQLite 页缓存和其它进程留余量
+    size_t by_memory = AvailableMemory() / 2 / memlimit_per_task;
+    size_t count = max<size_t>(1, min(limit, by_memory));
+
+    for (size_t i = 0; i < count; ++i) {
+        workers_.emplace_back(&HashingPool::WorkerLoop, this);
+    }
+}
+
+HashingPool::~HashingPool() {
+    {
+        lock_guard<mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    ready_.notify_all();
+    // 先处理完已排队的任务再退出
+    for (thread& worker : workers_) {
+        worker.join();
+    }
+}
+
+size_t HashingPool::AvailableMemory() {
+#ifdef _WIN32
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+    if (GlobalMemoryStatusEx(&status)) {
+        return static_cast<size_t>(status.ullAvailPhys);
+    }
+    return 0;
+#else
+    long pages = sysconf(_SC_AVPHYS_PAGES);
+    long page_size = sysconf(_SC_PAGESIZE);
+    if (pages <= 0 || page_size <= 0) {
+        return 0;
+    }
+    return static_cast<size_t>(pages) * static_cast<size_t>(page_size);
+#endif
+}
+
+void HashingPool::ParallelFor(size_t count, const function<void(size_t, size_t)>& body) {
+    size_t chunks = min(count, Concurrency());
+    if (chunks <= 1) {
+        body(0, count);
+        return;
+    }
+
+    vector<future<void>> pending;
+    pending.reserve(chunks);
+    for (size_t c = 0; c < chunks; ++c) {
+        size_t begin = count * c / chunks;
+        size_t end = count * (c + 1) / chunks;
+        pending.push_back(Submit([&body, begin, end] { body(begin, end); }));
+    }
+    // body 引用调用方栈帧，须等所有区间结束再抛出
+    exception_ptr error;
+    for (future<void>& f : pending) {
+        try {
+            f.get();
+        } catch (...) {
+            if (!error) {
+                error = current_exception();
+            }
+        }
+    }
+    if (error) {
+        rethrow_exception(error);
+    }
+}
+
+bool HashingPool::TrySubmit(function<void()> task) {
+    return Enqueue([task = move(task)] {
+        try {
+            task();
+        } catch (...) {
+        }
+    });
+}
+
+bool HashingPool::Enqueue(function<void()> task) {
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (stopping_ || queue_.size() >= max_queue_) {
+            return false;
+        }
+        queue_.push_back(move(task));
+    }
+    ready_.notify_one();
+    return true;
+}
+
+void HashingPool::WorkerLoop() {
+    for (;;) {
+        function<void()> task;
+        {
+            unique_lock<mutex> lock(mutex_);
+            ready_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                return;
+            }
+            task = move(queue_.front());
+            queue_.pop_front();
+        }
+        task();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include <vector>
+#include <stdexcept>
+#include <type_traits>
+
+// 队列已满或池正在关闭时 Submit 返回的 future 携带此异常
+class HashingQueueFull : public std::runtime_error {
+public:
+    HashingQueueFull() : std::runtime_error("Hashing queue is full") {}
+};
+
+// 有界 Argon2 工作池。并发数按可用内存 / 单次哈希 memlimit 计算（可再设上限），
+// 突发请求在队列中排队而不是同时申请内存；队列满时任务以 HashingQueueFull 结束
+class HashingPool {
+public:
+    // max_workers 为 0 时取 CPU 核数；最终并发数不超过内存允许的数量且至少为 1
+    HashingPool(size_t memlimit_per_task, size_t max_workers = 0, size_t max_queue = 1024);
+    ~HashingPool();
+
+    HashingPool(const HashingPool&) = delete;
+    HashingPool& operator=(const HashingPool&) = delete;
+
+    template <typename F>
+    std::future<std::invoke_result_t<F>> Submit(F&& fn);
+    // 不带 future 的提交：返回 false 表示队列已满或池正在关闭，task 不会执行。
+    // task 抛出的异常被丢弃，需要结果的调用方在 task 内自行捕获
+    bool TrySubmit(std::function<void()> task);
+
+    // 把 [0, count) 按工作线程数切成连续区间并行执行 body，全部完成后返回；
+    // 任一区间抛出的异常在所有区间结束后重新抛出。不可在池线程内调用
+    void ParallelFor(size_t count, const std::function<void(size_t begin, size_t end)>& body);
+
+    size_t Concurrency() const { return workers_.size(); }
+    static size_t AvailableMemory();
+
+private:
+    bool Enqueue(std::function<void()> task);
+    void WorkerLoop();
+
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> queue_;
+    size_t max_queue_;
+    bool stopping_ = false;
+    std::mutex mutex_;
+    std::condition_variable ready_;
+};
+
+template <typename F>
+std::future<std::invoke_result_t<F>> HashingPool::Submit(F&& fn) {
+    using Result = std::invoke_result_t<F>;
+    auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(fn));
+    std::future<Result> future = task->get_future();
+
+    if (!Enqueue([task] { (*task)(); })) {
+        std::promise<Result> rejected;
+        rejected.set_exception(std::make_exception_ptr(HashingQueueFull()));
+        return rejected.get_future();
+    }
+    return future;
+}
\ No newline at end of file
@@ -0,0 +1,59 @@
+#include "KdfPolicy.h"
+#include <sodium.h>
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+const size_t kCalibrationFloor = 8u * 1024 * 1024;
+
+std::chrono::duration<double, std::milli> measure(unsigned long long opslimit, size_t memlimit) {
+    unsigned char key[32];
+    unsigned char salt[crypto_pwhash_SALTBYTES] = {0};
+    const char password[] = "calibration";
+
+    auto start = std::chrono::steady_clock::now();
+    if (crypto_pwhash(key, sizeof(key), password, sizeof(password) - 1, salt,
+                      opslimit, memlimit, crypto_pwhash_ALG_ARGON2ID13) != 0) {
+        throw std::runtime_error("Key derivation failed during calibration");
+    }
+    return std::chrono::steady_clock::now() - start;
+}
+
+} // namespace
+
+KdfPolicy KdfPolicy::Interactive() {
+    return {crypto_pwhash_OPSLIMIT_INTERACTIVE, crypto_pwhash_MEMLIMIT_INTERACTIVE};
+}
+
+KdfPolicy KdfPolicy::Moderate() {
+    return {crypto_pwhash_OPSLIMIT_MODERATE, crypto_pwhash_MEMLIMIT_MODERATE};
+}
+
+KdfPolicy KdfPolicy::Sensitive() {
+    return {crypto_pwhash_OPSLIMIT_SENSITIVE, crypto_pwhash_MEMLIMIT_SENSITIVE};
+}
+
+KdfPolicy KdfPolicy::Calibrate(std::chrono::milliseconds target, size_t maxMemlimit) {
+    if (sodium_init() < 0) {
+        throw std::runtime_error("Libsodium initialization failed");
+    }
+    if (target.count() <= 0 || maxMemlimit < kCalibrationFloor) {
+        throw std::invalid_argument("Invalid calibration target");
+    }
+
+    KdfPolicy policy{1, maxMemlimit};
+    auto elapsed = measure(policy.opslimit, policy.memlimit);
+    while (elapsed > target && policy.memlimit / 2 >= kCalibrationFloor) {
+        policy.memlimit /= 2;
+        elapsed = measure(policy.opslimit, policy.memlimit);
+    }
+
+    // Argon2 time grows roughly linearly with the number of passes
+    if (elapsed.count() > 0 && elapsed < target) {
+        double passes = target.count() / elapsed.count();
+        policy.opslimit = std::clamp<unsigned long long>(
+            static_cast<unsigned long long>(passes), 1, crypto_pwhash_OPSLIMIT_MAX);
+    }
+    return policy;
+}
\ No newline at end of file
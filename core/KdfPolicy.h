@@ -0,0 +1,20 @@
+#pragma once
+#include <cstddef>
+#include <chrono>
+
+// Argon2id cost parameters shared by UserAuth (password hashes) and
+// CryptoModule (new codebook KDF headers).
+struct KdfPolicy {
+    unsigned long long opslimit;
+    size_t memlimit;
+
+    static KdfPolicy Interactive();
+    static KdfPolicy Moderate();
+    static KdfPolicy Sensitive();
+
+    // Benchmarks this host and returns the strongest parameters whose single
+    // derivation stays close to target: memory is kept as high as maxMemlimit
+    // allows (halved until one pass fits), then opslimit is scaled to fill the
+    // remaining time budget.
+    static KdfPolicy Calibrate(std::chrono::milliseconds target, size_t maxMemlimit);
+};
\ No newline at end of file
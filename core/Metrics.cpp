@@ -0,0 +1,151 @@
+#include "Metrics.h"
+#include <cstdio>
+
+using namespace std;
+
+namespace {
+
+constexpr const char* COUNTER_NAMES[] = {
+    "kdf_invocations",
+    "statements_prepared",
+    "statement_cache_hits",
+    "rows_read",
+    "bytes_encrypted",
+    "bytes_decrypted",
+    "slow_queries",
+};
+
+constexpr const char* OP_NAMES[] = {
+    "kdf",
+    "sql_prepare",
+    "sql_query",
+    "sql_commit",
+    "auth_register",
+    "auth_login",
+    "encrypt",
+    "decrypt",
+    "vault_write",
+    "vault_batch_write",
+    "vault_list",
+    "vault_get",
+    "vault_search",
+};
+
+static_assert(size(COUNTER_NAMES) == static_cast<size_t>(Metrics::Counter::Count_));
+static_assert(size(OP_NAMES) == static_cast<size_t>(Metrics::Op::Count_));
+
+size_t BucketOf(uint64_t duration_ns) {
+    size_t i = 0;
+    while (i < Metrics::BUCKET_BOUNDS_NS.size() && duration_ns > Metrics::BUCKET_BOUNDS_NS[i]) {
+        ++i;
+    }
+    return i;
+}
+
+string Seconds(uint64_t ns) {
+    char buffer[32];
+    snprintf(buffer, sizeof buffer, "%.9g", static_cast<double>(ns) / 1e9);
+    return buffer;
+}
+
+} // namespace
+
+Metrics& Metrics::Global() {
+    static Metrics instance;
+    return instance;
+}
+
+const char* Metrics::CounterName(Counter counter) {
+    return COUNTER_NAMES[static_cast<size_t>(counter)];
+}
+
+const char* Metrics::OpName(Op op) {
+    return OP_NAMES[static_cast<size_t>(op)];
+}
+
+void Metrics::SetSlowQueryThreshold(chrono::nanoseconds threshold) {
+    slow_threshold_ns_.store(static_cast<uint64_t>(threshold.count()), memory_order_relaxed);
+}
+
+void Metrics::Record(Op op, uint64_t duration_ns) {
+    AtomicHistogram& histogram = histograms_[static_cast<size_t>(op)];
+    histogram.buckets[BucketOf(duration_ns)].fetch_add(1, memory_order_relaxed);
+    histogram.sum_ns.fetch_add(duration_ns, memory_order_relaxed);
+}
+
+void Metrics::RecordQuery(const char* sql, uint64_t duration_ns) {
+    Record(Op::SqlQuery, duration_ns);
+    if (duration_ns < slow_threshold_ns_.load(memory_order_relaxed)) {
+        return;
+    }
+    counters_[static_cast<size_t>(Counter::SlowQueries)].fetch_add(1, memory_order_relaxed);
+
+    SlowQuery sample{sql ? sql : "", duration_ns, chrono::system_clock::now()};
+    lock_guard<mutex> lock(slow_mutex_);
+    if (slow_queries_.size() == SLOW_QUERY_CAPACITY) {
+        slow_queries_.pop_front();
+    }
+    slow_queries_.push_back(move(sample));
+}
+
+Metrics::Snapshot Metrics::TakeSnapshot() const {
+    Snapshot snapshot;
+    for (size_t i = 0; i < counters_.size(); ++i) {
+        snapshot.counters.emplace_back(COUNTER_NAMES[i], counters_[i].load(memory_order_relaxed));
+    }
+    for (size_t i = 0; i < histograms_.size(); ++i) {
+        Histogram histogram{OP_NAMES[i], {}, 0, 0};
+        for (size_t b = 0; b < BUCKET_COUNT; ++b) {
+            histogram.buckets[b] = histograms_[i].buckets[b].load(memory_order_relaxed);
+            histogram.count += histogram.buckets[b];
+        }
+        // count 由桶求和得到，保证与桶一致；sum 可能略超前于桶
+        histogram.sum_ns = histograms_[i].sum_ns.load(memory_order_relaxed);
+        snapshot.histograms.push_back(histogram);
+    }
+    lock_guard<mutex> lock(slow_mutex_);
+    snapshot.slow_queries.assign(slow_queries_.begin(), slow_queries_.end());
+    return snapshot;
+}
+
+string Metrics::ExportPrometheus() const {
+    return FormatPrometheus(TakeSnapshot());
+}
+
+string Metrics::FormatPrometheus(const Snapshot& snapshot) {
+    string out;
+    for (const auto& counter : snapshot.counters) {
+        string name = string("mypasswd_") + counter.first + "_total";
+        out += "# TYPE " + name + " counter\n";
+        out += name + " " + to_string(counter.second) + "\n";
+    }
+
+    out += "# TYPE mypasswd_operation_duration_seconds histogram\n";
+    for (const Histogram& histogram : snapshot.histograms) {
+        string label = string("op=\"") + histogram.op + "\"";
+        uint64_t cumulative = 0;
+        for (size_t b = 0; b < BUCKET_COUNT; ++b) {
+            cumulative += histogram.buckets[b];
+            string le = b < BUCKET_BOUNDS_NS.size() ? Seconds(BUCKET_BOUNDS_NS[b]) : "+Inf";
+            out += "mypasswd_operation_duration_seconds_bucket{" + label + ",le=\"" + le + "\"} " +
+                   to_string(cumulative) + "\n";
+        }
+        out += "mypasswd_operation_duration_seconds_sum{" + label + "} " + Seconds(histogram.sum_ns) + "\n";
+        out += "mypasswd_operation_duration_seconds_count{" + label + "} " + to_string(histogram.count) + "\n";
+    }
+    return out;
+}
+
+void Metrics::Reset() {
+    for (auto& counter : counters_) {
+        counter.store(0, memory_order_relaxed);
+    }
+    for (auto& histogram : histograms_) {
+        for (auto& bucket : histogram.buckets) {
+            bucket.store(0, memory_order_relaxed);
+        }
+        histogram.sum_ns.store(0, memory_order_relaxed);
+    }
+    lock_guard<mutex> lock(slow_mutex_);
+    slow_queries_.clear();
+}
\ No newline at end of file
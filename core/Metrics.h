@@ -0,0 +1,137 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 可选的热路径埋点：计数器、按操作的延迟直方图与慢查询样本，通过 TakeSnapshot() 按需拉取。
+// 默认关闭；关闭时每个埋点只有一次 relaxed 原子读，不取时钟也不写共享内存。
+// 进程内只有一份（Global()），各线程以 relaxed 原子累加，快照不是严格的时间点一致
+class Metrics {
+public:
+    enum class Counter {
+        KdfInvocations,       // Argon2 派生、哈希与校验
+        StatementsPrepared,   // 语句缓存未命中，真正调用 sqlite3_prepare
+        StatementCacheHits,
+        RowsRead,             // 读接口返回给调用方的行数
+        BytesEncrypted,       // 明文字节数
+        BytesDecrypted,
+        SlowQueries,
+        Count_
+    };
+
+    enum class Op {
+        Kdf,
+        SqlPrepare,
+        SqlQuery,         // 语句从租用到归还：绑定、全部 step 与读列
+        SqlCommit,        // COMMIT，包含 fsync
+        AuthRegister,
+        AuthLogin,
+        Encrypt,
+        Decrypt,
+        VaultWrite,       // 单条增删改
+        VaultBatchWrite,
+        VaultList,        // 分页、摘要列表与遍历
+        VaultGet,
+        VaultSearch,
+        Count_
+    };
+
+    // 延迟桶上界（纳秒），按 4 倍递增，从 1us 到 4s，最后一个桶为 +Inf
+    static constexpr size_t BUCKET_COUNT = 13;
+    static constexpr std::array<uint64_t, BUCKET_COUNT - 1> BUCKET_BOUNDS_NS = {
+        1000, 4000, 16000, 64000, 256000, 1000000, 4000000,
+        16000000, 64000000, 256000000, 1000000000, 4000000000,
+    };
+    static constexpr size_t SLOW_QUERY_CAPACITY = 32;
+
+    struct Histogram {
+        const char* op;
+        std::array<uint64_t, BUCKET_COUNT> buckets;   // 非累计，各桶独立计数
+        uint64_t count;
+        uint64_t sum_ns;
+    };
+
+    struct SlowQuery {
+        std::string sql;
+        uint64_t duration_ns;
+        std::chrono::system_clock::time_point at;
+    };
+
+    struct Snapshot {
+        std::vector<std::pair<const char*, uint64_t>> counters;
+        std::vector<Histogram> histograms;
+        std::vector<SlowQuery> slow_queries;   // 由旧到新，最多 SLOW_QUERY_CAPACITY 条
+    };
+
+    static Metrics& Global();
+
+    static bool Enabled() { return enabled_.load(std::memory_order_relaxed); }
+    static void SetEnabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+
+    // 超过阈值的语句记入慢查询样本，默认 100ms
+    void SetSlowQueryThreshold(std::chrono::nanoseconds threshold);
+
+    static void Add(Counter counter, uint64_t n = 1) {
+        if (Enabled()) {
+            Global().counters_[static_cast<size_t>(counter)].fetch_add(n, std::memory_order_relaxed);
+        }
+    }
+
+    void Record(Op op, uint64_t duration_ns);
+    // 记录语句耗时；超过阈值时同时保存 SQL 文本
+    void RecordQuery(const char* sql, uint64_t duration_ns);
+
+    Snapshot TakeSnapshot() const;
+    // Prometheus 文本格式（0.0.4）：计数器为 *_total，延迟为按 op 标注的秒级直方图
+    std::string ExportPrometheus() const;
+    static std::string FormatPrometheus(const Snapshot& snapshot);
+    void Reset();
+
+    static const char* CounterName(Counter counter);
+    static const char* OpName(Op op);
+
+    // 启用时取时钟的作用域计时器，关闭时只检查一次开关
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(Op op) : op_(op), start_(Enabled() ? Now() : 0) {}
+        ~ScopedTimer() {
+            if (start_ != 0) {
+                Global().Record(op_, Now() - start_);
+            }
+        }
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        Op op_;
+        uint64_t start_;
+    };
+
+    static uint64_t Now() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+private:
+    Metrics() = default;
+
+    struct AtomicHistogram {
+        std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets{};
+        std::atomic<uint64_t> sum_ns{0};
+    };
+
+    static inline std::atomic<bool> enabled_{false};
+
+    std::array<std::atomic<uint64_t>, static_cast<size_t>(Counter::Count_)> counters_{};
+    std::array<AtomicHistogram, static_cast<size_t>(Op::Count_)> histograms_{};
+    std::atomic<uint64_t> slow_threshold_ns_{100000000};
+
+    mutable std::mutex slow_mutex_;
+    std::deque<SlowQuery> slow_queries_;
+};
\ No newline at end of file
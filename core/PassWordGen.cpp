@@ -1,6 +1,95 @@
 #include "PassWordGen.h"
+#include "CharsetKernel.h"
 #include <sodium.h>
 #include <stdexcept>
+#include <cstring>
+
+namespace {
+
+// 按块获取随机字节，避免逐字符调用 RNG。
+// 每次补充 expected 个字节（限制在 [64, 4096] 内）：单个短密码不必取满整块再擦除整块
+class RandomStream {
+public:
+    explicit RandomStream(size_t expected)
+        : refill_(expected < 64 ? 64 : expected > sizeof(block_) ? sizeof(block_) : expected),
+          pos_(refill_) {}
+    ~RandomStream() { sodium_memzero(block_, refill_); }
+
+    unsigned char next()
+    {
+        if (pos_ == refill_) {
+            randombytes_buf(block_, refill_);
+            pos_ = 0;
+        }
+        return block_[pos_++];
+    }
+
+    // [0, bound) 内的无偏整数
+    uint32_t uniform(uint32_t bound)
+    {
+        const uint32_t limit = static_cast<uint32_t>(-bound) % bound;
+        for (;;) {
+            uint32_t value = 0;
+            for (int i = 0; i < 4; ++i) {
+                value = (value << 8) | next();
+            }
+            if (value >= limit) {
+                return value % bound;
+            }
+        }
+    }
+
+private:
+    unsigned char block_[4096];
+    size_t refill_;
+    size_t pos_;
+};
+
+const size_t kBulkBlock = 4096;
+// 低于此长度时向量内核的准备开销不划算
+const size_t kBulkThreshold = 256;
+
+// 大批量：整块随机字节交给向量化内核映射与拒绝。
+// 剩余空间足够容纳内核越界写入时直接写目标，否则经暂存区拷贝
+void fillBulk(const SamplingTable& table, char* out, size_t count)
+{
+    unsigned char block[kBulkBlock];
+    char staged[kBulkBlock + kCharsetKernelSlack];
+
+    size_t written = 0;
+    while (written < count) {
+        randombytes_buf(block, sizeof(block));
+        size_t remaining = count - written;
+        if (remaining >= sizeof(staged)) {
+            written += MapCharsetBlock(table, block, sizeof(block), out + written);
+        } else {
+            size_t produced = MapCharsetBlock(table, block, sizeof(block), staged);
+            size_t used = produced < remaining ? produced : remaining;
+            std::memcpy(out + written, staged, used);
+            written += used;
+        }
+    }
+    sodium_memzero(block, sizeof(block));
+    sodium_memzero(staged, sizeof(staged));
+}
+
+// 内层循环：查表并以比较结果推进写指针，被拒绝的字节会在下一轮被覆盖
+void fill(const SamplingTable& table, char* out, size_t count, RandomStream& rng)
+{
+    if (count >= kBulkThreshold) {
+        fillBulk(table, out, count);
+        return;
+    }
+
+    size_t written = 0;
+    while (written < count) {
+        unsigned char byte = rng.next();
+        out[written] = table.map[byte];
+        written += byte < table.limit;
+    }
+}
+
+} // namespace
 
 const std::string PasswordGenerator::basic_charset = 
     "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
@@ -52,5 +141,89 @@ std::string PasswordGenerator::generateExtended() const
         password += charset[random_index];
     }
     
+    return password;
+}
+
+void PasswordGenerator::generateBatch(size_t count, std::string_view charset, std::string& out) const
+{
+    out.resize(count * length_);
+    generateBatch(count, charset, std::span<char>(out.data(), out.size()));
+}
+
+void PasswordGenerator::generateBatch(size_t count, std::string_view charset, std::span<char> out) const
+{
+    const size_t charset_size = charset.size();
+    if (charset_size == 0 || charset_size > 256) {
+        throw std::invalid_argument("Charset must contain 1-256 characters");
+    }
+    const size_t total = count * length_;
+    if (out.size() < total) {
+        throw std::invalid_argument("Output buffer is too small");
+    }
+
+    // 只接受小于 charset_size 整数倍的字节，取模后各字符概率相同
+    const SamplingTable table = SamplingTable::FromCharset(charset);
+    // 表的接受率不低于一半；达到 kBulkThreshold 时走 fillBulk，不使用 rng
+    RandomStream rng(total < kBulkThreshold ? 2 * total : 0);
+    fill(table, out.data(), total, rng);
+}
+
+std::string PasswordGenerator::generate(const PasswordPolicy& policy) const
+{
+    const bool exclude = policy.exclude_ambiguous;
+    const SamplingTable by_class_tables[4] = {
+        SamplingTable::FromClasses(CHAR_UPPER, exclude),
+        SamplingTable::FromClasses(CHAR_LOWER, exclude),
+        SamplingTable::FromClasses(CHAR_DIGIT, exclude),
+        SamplingTable::FromClasses(CHAR_SYMBOL, exclude),
+    };
+    const SamplingTable* const by_class[4] = {
+        &by_class_tables[0], &by_class_tables[1], &by_class_tables[2], &by_class_tables[3],
+    };
+    const SamplingTable all = SamplingTable::FromClasses(policy.allowed | policy.required, exclude);
+    return generateWith(policy, all, by_class);
+}
+
+std::string PasswordGenerator::generateWith(const PasswordPolicy& policy,
+                                            const SamplingTable& all,
+                                            const SamplingTable* const by_class[4]) const
+{
+    if (length_ < policy.min_length || length_ > policy.max_length) {
+        throw std::invalid_argument("Password length is outside the policy bounds");
+    }
+    if (all.size == 0) {
+        throw std::invalid_argument("Policy allows no characters");
+    }
+
+    size_t reserved = 0;
+    for (int c = 0; c < 4; ++c) {
+        if (policy.required & (1u << c)) {
+            reserved += policy.min_per_class;
+        }
+    }
+    if (reserved > length_) {
+        throw std::invalid_argument("Policy requires more characters than the password length");
+    }
+
+    std::string password(length_, '\0');
+    // 逐字符采样按一半接受率估计约 2 字节，洗牌每步 4 字节
+    RandomStream rng(6 * length_);
+
+    // 先填满各必需类别的最少个数，再用全集补齐
+    size_t pos = 0;
+    for (int c = 0; c < 4; ++c) {
+        if (policy.required & (1u << c)) {
+            fill(*by_class[c], &password[pos], policy.min_per_class, rng);
+            pos += policy.min_per_class;
+        }
+    }
+    fill(all, &password[pos], length_ - pos, rng);
+
+    // Fisher-Yates 洗牌，打散必需字符的位置；自定义策略允许长度 0，
+    // 从 length_ 倒数可避免 length_ - 1 回绕
+    for (size_t i = length_; i > 1; --i) {
+        size_t j = rng.uniform(static_cast<uint32_t>(i));
+        std::swap(password[i - 1], password[j]);
+    }
     return password;
 }
\ No newline at end of file
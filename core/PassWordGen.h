@@ -1,6 +1,10 @@
 #pragma once
 #include <string>
 #include <cstddef>
+#include <span>
+#include <string_view>
+#include "PasswordPolicy.h"
+#include "CharsetTable.h"
 
 class PasswordGenerator {
 public:
@@ -9,9 +13,44 @@ public:
     std::string generateBasic() const;    // 仅字母数字
     std::string generateExtended() const; // 包含特殊字符
 
+    // 批量生成 count 个长度为 length_ 的密码，首尾相接写入同一块缓冲区：
+    // 第 i 个密码位于 [i * length_, (i + 1) * length_)。
+    // 随机数按大块 randombytes_buf 获取，拒绝采样保证无偏，不做逐个密码的堆分配
+    void generateBatch(size_t count, std::string_view charset, std::string& out) const;
+    // 写入调用方提供的存储，out 至少需要 count * length_ 字节
+    void generateBatch(size_t count, std::string_view charset, std::span<char> out) const;
+
+    // 按策略一次生成：每个必需类别先取 min_per_class 个字符，其余位置从允许的
+    // 全集中取，最后整体洗牌。不做"生成后检查再重试"
+    std::string generate(const PasswordPolicy& policy) const;
+    // 编译期策略：字符表在编译期展开为常量查找表
+    template <PasswordPolicy Policy>
+    std::string generate() const;
+
+    size_t length() const { return length_; }
+    static const std::string& basicCharset() { return basic_charset; }
+    static const std::string& extendedCharset() { return extended_charset; }
+
 private:
     size_t length_;
+
+    std::string generateWith(const PasswordPolicy& policy,
+                             const SamplingTable& all,
+                             const SamplingTable* const by_class[4]) const;
     
     static const std::string basic_charset;     // 大小写字母+数字
     static const std::string extended_charset;  // 原字符集
-};
\ No newline at end of file
+};
+
+template <PasswordPolicy Policy>
+std::string PasswordGenerator::generate() const
+{
+    constexpr bool exclude = Policy.exclude_ambiguous;
+    static const SamplingTable* const by_class[4] = {
+        &kSamplingTable<CHAR_UPPER, exclude>,
+        &kSamplingTable<CHAR_LOWER, exclude>,
+        &kSamplingTable<CHAR_DIGIT, exclude>,
+        &kSamplingTable<CHAR_SYMBOL, exclude>,
+    };
+    return generateWith(Policy, kSamplingTable<Policy.allowed | Policy.required, exclude>, by_class);
+}
\ No newline at end of file
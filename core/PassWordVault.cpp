@@ -1,93 +1,257 @@
 #include "PassWordVault.h"
+#include "VaultEnvelope.h"
+#include "EntryCache.h"
+#include "UserCache.h"
 #include <stdexcept>
 #include <algorithm>
+#include <memory>
 
 using namespace std;
 
-PasswordVault::PasswordVault(sqlite3* db) : db_(db) {
-    if (!db_) {
-        throw invalid_argument("Invalid database connection");
+namespace {
+
+string ColumnText(sqlite3_stmt* stmt, int col) {
+    // 按字节数构造：BLOB 存储的密文可能含 NUL
+    const unsigned char* text = sqlite3_column_text(stmt, col);
+    return text ? string(reinterpret_cast<const char*>(text), sqlite3_column_bytes(stmt, col)) : string();
+}
+
+span<const uint8_t> AsBytes(const string& text) {
+    return span<const uint8_t>(reinterpret_cast<const uint8_t*>(text.data()), text.size());
+}
+
+span<const uint8_t> ColumnBytes(sqlite3_stmt* stmt, int col) {
+    const uint8_t* data = static_cast<const uint8_t*>(sqlite3_column_blob(stmt, col));
+    return span<const uint8_t>(data, data ? static_cast<size_t>(sqlite3_column_bytes(stmt, col)) : 0);
+}
+
+// 空 span 的 data() 可能为空指针，sqlite3_bind_blob 会把它当作 NULL 绑定
+void BindBytes(sqlite3_stmt* stmt, int index, span<const uint8_t> bytes) {
+    if (bytes.data()) {
+        sqlite3_bind_blob(stmt, index, bytes.data(), static_cast<int>(bytes.size()), SQLITE_STATIC);
+    } else {
+        sqlite3_bind_zeroblob(stmt, index, 0);
+    }
+}
+
+PasswordVault::PasswordEntry ReadEntry(sqlite3_stmt* stmt) {
+    PasswordVault::PasswordEntry entry;
+    entry.id = sqlite3_column_int(stmt, 0);
+    entry.address = ColumnText(stmt, 1);
+    entry.public_key = ColumnText(stmt, 2);
+    entry.encrypted_password = ColumnText(stmt, 3);
+    entry.notes = ColumnText(stmt, 4);
+    entry.created_time = ColumnText(stmt, 5);
+    return entry;
+}
+
+// CURRENT_TIMESTAMP 的格式；导入的时间不合此格式会打乱按时间的分页
+bool IsTimestamp(const string& text) {
+    static const char pattern[] = "dddd-dd-dd dd:dd:dd";
+    if (text.size() != sizeof pattern - 1) {
+        return false;
+    }
+    for (size_t i = 0; i < text.size(); ++i) {
+        bool digit = text[i] >= '0' && text[i] <= '9';
+        if (pattern[i] == 'd' ? !digit : text[i] != pattern[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+constexpr size_t SYNC_ID_SIZE = 16;
+
+// 同步用的 updated_time：CURRENT_TIMESTAMP 格式，可带毫秒（触发器写入的格式）
+bool IsChangeTimestamp(const string& text) {
+    if (text.size() == 23) {
+        return IsTimestamp(text.substr(0, 19)) && text[19] == '.' &&
+               all_of(text.begin() + 20, text.end(), [](char c) { return c >= '0' && c <= '9'; });
+    }
+    return IsTimestamp(text);
+}
+
+// 后写者胜；时间相同时删除优先，再比较密文字节，保证各副本得出相同结论
+bool ChangeWins(const string& time, bool deleted, const string& blob,
+                const string& local_time, bool local_deleted, const string& local_blob) {
+    if (time != local_time) {
+        return time > local_time;
+    }
+    if (deleted != local_deleted) {
+        return deleted;
+    }
+    return !deleted && blob > local_blob;
+}
+
+// 游标格式 "<entry_id>:<created_time>"，对调用方不透明
+string MakeCursor(const string& created_time, int entry_id) {
+    return to_string(entry_id) + ":" + created_time;
+}
+
+bool ParseCursor(const string& cursor, string& created_time, int& entry_id) {
+    size_t sep = cursor.find(':');
+    if (sep == 0 || sep == string::npos) {
+        return false;
+    }
+    try {
+        size_t used = 0;
+        entry_id = stoi(cursor.substr(0, sep), &used);
+        if (used != sep) {
+            return false;
+        }
+    } catch (const exception&) {
+        return false;
+    }
+    created_time = cursor.substr(sep + 1);
+    return true;
+}
+
+// 把用户输入拆成词并逐个加双引号和前缀通配，避免 FTS5 语法注入
+string BuildSearchQuery(const string& input) {
+    string query;
+    string token;
+    auto flush = [&]() {
+        if (!token.empty()) {
+            if (!query.empty()) {
+                query += ' ';
+            }
+            query += "\"" + token + "\"*";
+            token.clear();
+        }
+    };
+    for (unsigned char c : input) {
+        if (isalnum(c) || c >= 0x80) {
+            token += static_cast<char>(c);
+        } else {
+            flush();
+        }
+    }
+    flush();
+    return query;
+}
+
+} // namespace
+
+PasswordVault::PasswordVault(sqlite3* db)
+    : owned_database_(make_unique<Database>(db)),
+      database_(*owned_database_),
+      readers_(nullptr),
+      db_(db) {}
+
+PasswordVault::PasswordVault(Database& database, ConnectionPool* readers)
+    : database_(database),
+      readers_(readers),
+      db_(database.Handle()) {}
+
+ConnectionPool::Lease PasswordVault::AcquireReader() {
+    if (readers_) {
+        return readers_->Acquire();
+    }
+    return ConnectionPool::Lease(nullptr, &database_);
+}
+
+void PasswordVault::SetEntryCache(shared_ptr<EntryCache> cache) {
+    entry_cache_ = move(cache);
+}
+
+void PasswordVault::SetUserCache(shared_ptr<UserCache> cache) {
+    if (cache) {
+        cache->EnableCodebooks();
+    }
+    user_cache_ = move(cache);
+}
+
+void PasswordVault::InvalidateCachedEntry(int entry_id) {
+    if (entry_cache_) {
+        database_.AfterCommit([cache = entry_cache_, entry_id] { cache->InvalidateEntry(entry_id); });
     }
 }
 
-bool PasswordVault::CreateCodebook(const string& username, const string& name) {
+void PasswordVault::InvalidateCachedCodebook(int codebook_id) {
+    if (entry_cache_) {
+        database_.AfterCommit([cache = entry_cache_, codebook_id] { cache->InvalidateCodebook(codebook_id); });
+    }
+}
+
+WriteResult PasswordVault::CreateCodebook(const string& username, const string& name) {
+    auto lock = database_.Lock();
     if (!ValidateCodebookName(name)) {
         throw invalid_argument("Codebook name is invalid");
     }
 
+    // 用户不存在由外键拒绝，重名由 DO NOTHING 变为零行返回，一条语句完成
     const char* sql = R"(
         INSERT INTO Codebook (username, codebook_name)
         VALUES (?, ?)
         ON CONFLICT(username, codebook_name) DO NOTHING
+        RETURNING codebook_id, created_time
     )";
     
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        throw runtime_error("Prepare failed: " + string(sqlite3_errmsg(db_)));
-    }
+    Statement stmt = database_.Prepare(sql);
 
     sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_STATIC);
     sqlite3_bind_text(stmt, 2, name.c_str(), -1, SQLITE_STATIC);
     
-    bool success = sqlite3_step(stmt) == SQLITE_DONE;
-    sqlite3_finalize(stmt);
-    return success;
-}
-
-bool PasswordVault::DeleteCodebook(int codebook_id) {
-    if (!CheckCodebookExists(codebook_id)) {
-        return false;
+    int rc = sqlite3_step(stmt);
+    if (rc == SQLITE_DONE) {
+        return {WriteStatus::AlreadyExists};
     }
-
-    if (!BeginTransaction()) {
-        throw runtime_error("Failed to start transaction");
+    if (rc != SQLITE_ROW) {
+        return {database_.StatusOf(rc)};
     }
+    // 与 DeleteCodebook 相同：step 到 SQLITE_DONE 提交后才更新缓存
+    int64_t codebook_id = sqlite3_column_int64(stmt, 0);
+    UserCache::Codebook added{static_cast<int>(codebook_id), name, ColumnText(stmt, 1)};
+    rc = sqlite3_step(stmt);
+    if (rc != SQLITE_DONE) {
+        return {database_.StatusOf(rc)};
+    }
+    if (user_cache_) {
+        database_.AfterCommit([cache = user_cache_, username, added] { cache->AddCodebook(username, added); });
+    }
+    return {WriteStatus::Ok, codebook_id};
+}
 
-    try {
-        // 删除关联条目
-        const char* deleteEntriesSql = "DELETE FROM PasswordEntry WHERE codebook_id = ?";
-        sqlite3_stmt* stmt;
-        
-        if (sqlite3_prepare_v2(db_, deleteEntriesSql, -1, &stmt, nullptr) != SQLITE_OK) {
-            RollbackTransaction();
-            throw runtime_error("Prepare failed: " + string(sqlite3_errmsg(db_)));
-        }
-        
-        sqlite3_bind_int(stmt, 1, codebook_id);
-        if (sqlite3_step(stmt) != SQLITE_DONE) {
-            sqlite3_finalize(stmt);
-            RollbackTransaction();
-            throw runtime_error("Delete entries failed: " + string(sqlite3_errmsg(db_)));
-        }
-        sqlite3_finalize(stmt);
-
-        // 删除密码本
-        const char* deleteCodebookSql = "DELETE FROM Codebook WHERE codebook_id = ?";
-        if (sqlite3_prepare_v2(db_, deleteCodebookSql, -1, &stmt, nullptr) != SQLITE_OK) {
-            RollbackTransaction();
-            throw runtime_error("Prepare failed: " + string(sqlite3_errmsg(db_)));
-        }
-        
-        sqlite3_bind_int(stmt, 1, codebook_id);
-        if (sqlite3_step(stmt) != SQLITE_DONE) {
-            sqlite3_finalize(stmt);
-            RollbackTransaction();
-            throw runtime_error("Delete codebook failed: " + string(sqlite3_errmsg(db_)));
-        }
-        sqlite3_finalize(stmt);
-
-        if (!CommitTransaction()) {
-            throw runtime_error("Commit failed: " + string(sqlite3_errmsg(db_)));
-        }
-        return true;
+WriteResult PasswordVault::DeleteCodebook(int codebook_id) {
+    auto lock = database_.Lock();
+    const char* sql = "DELETE FROM Codebook WHERE codebook_id = ? RETURNING username";
+    Statement stmt = database_.Prepare(sql);
 
-    } catch (...) {
-        RollbackTransaction();
-        throw;
+    sqlite3_bind_int(stmt, 1, codebook_id);
+    int rc = sqlite3_step(stmt);
+    if (rc == SQLITE_DONE) {
+        return {WriteStatus::NotFound};
+    }
+    if (rc != SQLITE_ROW) {
+        return {database_.StatusOf(rc)};
+    }
+    // 自动提交时 RETURNING 语句要 step 到 SQLITE_DONE 才提交，缓存只能在此之后更新，
+    // 否则并发读者可能读到未提交前的数据并以新的 generation 放回缓存
+    string username = ColumnText(stmt, 0);
+    rc = sqlite3_step(stmt);
+    if (rc != SQLITE_DONE) {
+        return {database_.StatusOf(rc)};
     }
+    if (user_cache_) {
+        database_.AfterCommit([cache = user_cache_, username, codebook_id] {
+            cache->RemoveCodebook(username, codebook_id);
+        });
+    }
+    InvalidateCachedCodebook(codebook_id);
+    return {WriteStatus::Ok};
 }
 
 vector<PasswordVault::Codebook> PasswordVault::GetUserCodebooks(const string& username) {
+    vector<Codebook> codebooks;
+    vector<UserCache::Codebook> cached;
+    if (user_cache_ && user_cache_->GetCodebooks(username, cached)) {
+        for (UserCache::Codebook& codebook : cached) {
+            codebooks.push_back({codebook.id, move(codebook.name), move(codebook.created_time)});
+        }
+        return codebooks;
+    }
+    uint64_t generation = user_cache_ ? user_cache_->Generation() : 0;
+
     const char* sql = R"(
         SELECT codebook_id, codebook_name, created_time
         FROM Codebook
@@ -95,56 +259,64 @@ vector<PasswordVault::Codebook> PasswordVault::GetUserCodebooks(const string& us
         ORDER BY created_time DESC
     )";
     
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        throw runtime_error("Prepare failed: " + string(sqlite3_errmsg(db_)));
-    }
+    ConnectionPool::Lease reader = AcquireReader();
+    Statement stmt = reader->Prepare(sql);
 
     sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_STATIC);
     
-    vector<Codebook> codebooks;
     while (sqlite3_step(stmt) == SQLITE_ROW) {
         Codebook cb;
         cb.id = sqlite3_column_int(stmt, 0);
         cb.name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
         cb.created_time = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+        cached.push_back({cb.id, cb.name, cb.created_time});
         codebooks.push_back(cb);
     }
+    if (user_cache_) {
+        user_cache_->PutCodebooks(username, move(cached), generation);
+    }
 
-    sqlite3_finalize(stmt);
     return codebooks;
 }
 
-bool PasswordVault::AddEntry(int codebook_id,
-                           const string& address,
-                           const string& public_key,
-                           const string& encrypted_password,
-                           const string& notes) 
+WriteResult PasswordVault::AddEntry(int codebook_id,
+                                    const string& address,
+                                    const string& public_key,
+                                    const string& encrypted_password,
+                                    const string& notes)
 {
-    if (!CheckCodebookExists(codebook_id)) {
-        return false;
-    }
+    return AddEntryBinary(codebook_id, address, AsBytes(public_key), AsBytes(encrypted_password), notes);
+}
 
+WriteResult PasswordVault::AddEntryBinary(int codebook_id,
+                                        const string& address,
+                                        span<const uint8_t> public_key,
+                                        span<const uint8_t> encrypted_password,
+                                        const string& notes)
+{
+    Metrics::ScopedTimer timer(Metrics::Op::VaultWrite);
+    auto lock = database_.Lock();
+    // 密码本不存在由外键拒绝，不再单独查询
     const char* sql = R"(
         INSERT INTO PasswordEntry 
         (codebook_id, address, public_key, encrypted_password, notes)
         VALUES (?, ?, ?, ?, ?)
+        RETURNING entry_id
     )";
 
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        throw runtime_error("Prepare failed: " + string(sqlite3_errmsg(db_)));
-    }
+    Statement stmt = database_.Prepare(sql);
 
     sqlite3_bind_int(stmt, 1, codebook_id);
     sqlite3_bind_text(stmt, 2, address.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 3, public_key.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 4, encrypted_password.c_str(), -1, SQLITE_STATIC);
+    BindBytes(stmt, 3, public_key);
+    BindBytes(stmt, 4, encrypted_password);
     sqlite3_bind_text(stmt, 5, notes.c_str(), -1, SQLITE_STATIC);
 
-    bool success = sqlite3_step(stmt) == SQLITE_DONE;
-    sqlite3_finalize(stmt);
-    return success;
+    int rc = sqlite3_step(stmt);
+    if (rc != SQLITE_ROW) {
+        return {database_.StatusOf(rc)};
+    }
+    return {WriteStatus::Ok, sqlite3_column_int64(stmt, 0)};
 }
 
 vector<PasswordVault::PasswordEntry> PasswordVault::GetEntries(int codebook_id, 
@@ -152,19 +324,18 @@ vector<PasswordVault::PasswordEntry> PasswordVault::GetEntries(int codebook_id,
                                                              int page, 
                                                              int page_size) 
 {
+    Metrics::ScopedTimer timer(Metrics::Op::VaultList);
     const char* sql = R"(
         SELECT entry_id, address, public_key, encrypted_password, notes, created_time
         FROM PasswordEntry
         WHERE codebook_id = ? 
         AND address LIKE ?
-        ORDER BY created_time DESC
+        ORDER BY created_time DESC, entry_id DESC
         LIMIT ? OFFSET ?
     )";
 
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        throw runtime_error("Prepare failed: " + string(sqlite3_errmsg(db_)));
-    }
+    ConnectionPool::Lease reader = AcquireReader();
+    Statement stmt = reader->Prepare(sql);
 
     string filter_pattern = "%" + filter + "%";
     int offset = page * page_size;
@@ -176,36 +347,195 @@ vector<PasswordVault::PasswordEntry> PasswordVault::GetEntries(int codebook_id,
 
     vector<PasswordEntry> entries;
     while (sqlite3_step(stmt) == SQLITE_ROW) {
-        PasswordEntry entry;
-        entry.id = sqlite3_column_int(stmt, 0);
-        entry.address = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        entry.public_key = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-        entry.encrypted_password = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-        entry.notes = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
-        entry.created_time = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5));
-        entries.push_back(entry);
+        entries.push_back(ReadEntry(stmt));
     }
 
-    sqlite3_finalize(stmt);
+    Metrics::Add(Metrics::Counter::RowsRead, entries.size());
     return entries;
 }
 
-bool PasswordVault::UpdateEntry(int entry_id,
-    const std::string& new_address,
-    const std::string& new_public_key,
-    const std::string& new_encrypted_password,
-    const std::string& new_notes) 
+vector<PasswordVault::PasswordEntry> PasswordVault::GetEntriesAfter(int codebook_id,
+                                                                  const string& cursor,
+                                                                  string& next_cursor,
+                                                                  int page_size,
+                                                                  const string& filter)
 {
-    // 验证输入参数
-    if (new_address.empty() || new_address.length() > 253) {
-        throw std::invalid_argument("Address must be 1-253 characters");
+    Metrics::ScopedTimer timer(Metrics::Op::VaultList);
+    if (page_size <= 0) {
+        throw invalid_argument("Page size must be positive");
+    }
+
+    // 行值比较 (created_time, entry_id) < (?, ?) 可直接在索引上定位起点
+    const char* firstSql = R"(
+        SELECT entry_id, address, public_key, encrypted_password, notes, created_time
+        FROM PasswordEntry
+        WHERE codebook_id = ?
+        AND address LIKE ?
+        ORDER BY created_time DESC, entry_id DESC
+        LIMIT ?
+    )";
+    const char* nextSql = R"(
+        SELECT entry_id, address, public_key, encrypted_password, notes, created_time
+        FROM PasswordEntry
+        WHERE codebook_id = ?
+        AND address LIKE ?
+        AND (created_time, entry_id) < (?, ?)
+        ORDER BY created_time DESC, entry_id DESC
+        LIMIT ?
+    )";
+
+    string last_time;
+    int last_id = 0;
+    bool has_cursor = !cursor.empty();
+    if (has_cursor && !ParseCursor(cursor, last_time, last_id)) {
+        throw invalid_argument("Invalid page cursor");
+    }
+
+    ConnectionPool::Lease reader = AcquireReader();
+    Statement stmt = reader->Prepare(has_cursor ? nextSql : firstSql);
+
+    string filter_pattern = "%" + filter + "%";
+    sqlite3_bind_int(stmt, 1, codebook_id);
+    sqlite3_bind_text(stmt, 2, filter_pattern.c_str(), -1, SQLITE_STATIC);
+    if (has_cursor) {
+        sqlite3_bind_text(stmt, 3, last_time.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int(stmt, 4, last_id);
+        sqlite3_bind_int(stmt, 5, page_size + 1);
+    } else {
+        sqlite3_bind_int(stmt, 3, page_size + 1);
+    }
+
+    // 多取一行用于判断是否还有下一页，避免返回空的末页
+    vector<PasswordEntry> entries;
+    entries.reserve(page_size);
+    next_cursor.clear();
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        if (static_cast<int>(entries.size()) == page_size) {
+            const PasswordEntry& last = entries.back();
+            next_cursor = MakeCursor(last.created_time, last.id);
+            break;
+        }
+        entries.push_back(ReadEntry(stmt));
+    }
+
+    Metrics::Add(Metrics::Counter::RowsRead, entries.size());
+    return entries;
+}
+
+vector<PasswordVault::EntrySummary> PasswordVault::ListEntrySummaries(int codebook_id,
+                                                                   const string& cursor,
+                                                                   string& next_cursor,
+                                                                   int page_size,
+                                                                   const string& filter)
+{
+    Metrics::ScopedTimer timer(Metrics::Op::VaultList);
+    if (page_size <= 0) {
+        throw invalid_argument("Page size must be positive");
+    }
+
+    const char* firstSql = R"(
+        SELECT entry_id, address, created_time
+        FROM PasswordEntry
+        WHERE codebook_id = ?
+        AND address LIKE ?
+        ORDER BY created_time DESC, entry_id DESC
+        LIMIT ?
+    )";
+    const char* nextSql = R"(
+        SELECT entry_id, address, created_time
+        FROM PasswordEntry
+        WHERE codebook_id = ?
+        AND address LIKE ?
+        AND (created_time, entry_id) < (?, ?)
+        ORDER BY created_time DESC, entry_id DESC
+        LIMIT ?
+    )";
+
+    string last_time;
+    int last_id = 0;
+    bool has_cursor = !cursor.empty();
+    if (has_cursor && !ParseCursor(cursor, last_time, last_id)) {
+        throw invalid_argument("Invalid page cursor");
     }
-    if (new_public_key.empty() || new_public_key.length() > 4096) {
-        throw std::invalid_argument("Public key is invalid");
+
+    ConnectionPool::Lease reader = AcquireReader();
+    Statement stmt = reader->Prepare(has_cursor ? nextSql : firstSql);
+
+    string filter_pattern = "%" + filter + "%";
+    sqlite3_bind_int(stmt, 1, codebook_id);
+    sqlite3_bind_text(stmt, 2, filter_pattern.c_str(), -1, SQLITE_STATIC);
+    if (has_cursor) {
+        sqlite3_bind_text(stmt, 3, last_time.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int(stmt, 4, last_id);
+        sqlite3_bind_int(stmt, 5, page_size + 1);
+    } else {
+        sqlite3_bind_int(stmt, 3, page_size + 1);
+    }
+
+    vector<EntrySummary> summaries;
+    summaries.reserve(page_size);
+    next_cursor.clear();
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        if (static_cast<int>(summaries.size()) == page_size) {
+            const EntrySummary& last = summaries.back();
+            next_cursor = MakeCursor(last.created_time, last.id);
+            break;
+        }
+        summaries.push_back({sqlite3_column_int(stmt, 0), ColumnText(stmt, 1), ColumnText(stmt, 2)});
+    }
+
+    Metrics::Add(Metrics::Counter::RowsRead, summaries.size());
+    return summaries;
+}
+
+bool PasswordVault::GetEntryDetail(int entry_id, PasswordEntry& entry) {
+    Metrics::ScopedTimer timer(Metrics::Op::VaultGet);
+    if (entry_cache_ && entry_cache_->GetEntry(entry_id, entry)) {
+        return true;
+    }
+    // 读库前取 generation：读取期间若有失效，回填会被丢弃
+    uint64_t generation = entry_cache_ ? entry_cache_->Generation() : 0;
+
+    const char* sql = R"(
+        SELECT entry_id, address, public_key, encrypted_password, notes, created_time, codebook_id
+        FROM PasswordEntry
+        WHERE entry_id = ?
+    )";
+
+    ConnectionPool::Lease reader = AcquireReader();
+    Statement stmt = reader->Prepare(sql);
+
+    sqlite3_bind_int(stmt, 1, entry_id);
+    if (sqlite3_step(stmt) != SQLITE_ROW) {
+        return false;
     }
-    if (new_encrypted_password.empty() || new_encrypted_password.length() > 512) {
-        throw std::invalid_argument("Encrypted password is invalid");
+    entry = ReadEntry(stmt);
+    if (entry_cache_) {
+        entry_cache_->PutEntry(sqlite3_column_int(stmt, 6), entry, generation);
     }
+    Metrics::Add(Metrics::Counter::RowsRead);
+    return true;
+}
+
+WriteResult PasswordVault::UpdateEntry(int entry_id,
+                                       const std::string& new_address,
+                                       const std::string& new_public_key,
+                                       const std::string& new_encrypted_password,
+                                       const std::string& new_notes)
+{
+    return UpdateEntryBinary(entry_id, new_address, AsBytes(new_public_key), AsBytes(new_encrypted_password), new_notes);
+}
+
+WriteResult PasswordVault::UpdateEntryBinary(int entry_id,
+                                           const string& new_address,
+                                           span<const uint8_t> new_public_key,
+                                           span<const uint8_t> new_encrypted_password,
+                                           const string& new_notes)
+{
+    Metrics::ScopedTimer timer(Metrics::Op::VaultWrite);
+    auto lock = database_.Lock();
+    // 验证输入参数
+    ValidateEntryFields(new_address, new_public_key.size(), new_encrypted_password.size());
 
     const char* sql = R"(
         UPDATE PasswordEntry SET
@@ -216,59 +546,1067 @@ bool PasswordVault::UpdateEntry(int entry_id,
         WHERE entry_id = ?
         )";
 
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        throw std::runtime_error("Prepare failed: " + std::string(sqlite3_errmsg(db_)));
-    }
+    Statement stmt = database_.Prepare(sql);
 
     // 绑定参数
     sqlite3_bind_text(stmt, 1, new_address.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 2, new_public_key.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 3, new_encrypted_password.c_str(), -1, SQLITE_STATIC);
+    BindBytes(stmt, 2, new_public_key);
+    BindBytes(stmt, 3, new_encrypted_password);
     sqlite3_bind_text(stmt, 4, new_notes.c_str(), -1, SQLITE_STATIC);
     sqlite3_bind_int(stmt, 5, entry_id);
 
-    bool success = sqlite3_step(stmt) == SQLITE_DONE;
-    int rowsAffected = sqlite3_changes(db_);
-    sqlite3_finalize(stmt);
+    int rc = sqlite3_step(stmt);
+    if (rc != SQLITE_DONE) {
+        return {database_.StatusOf(rc)};
+    }
 
     // 确保确实更新了记录
-    return success && (rowsAffected > 0);
+    if (sqlite3_changes(db_) == 0) {
+        return {WriteStatus::NotFound};
+    }
+    InvalidateCachedEntry(entry_id);
+    return {WriteStatus::Ok};
 }
 
-// 事务处理方法
-bool PasswordVault::BeginTransaction() {
-    return sqlite3_exec(db_, "BEGIN TRANSACTION", nullptr, nullptr, nullptr) == SQLITE_OK;
-}
+vector<PasswordVault::BatchResult> PasswordVault::AddEntries(int codebook_id,
+                                                             span<const EntryInput> entries)
+{
+    Metrics::ScopedTimer timer(Metrics::Op::VaultBatchWrite);
+    // 与 UpdateEntries 相同的字段检查，在取得写锁前逐行完成；不合法的行只记为失败
+    vector<string> invalid(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const EntryInput& entry = entries[i];
+        try {
+            ValidateEntryFields(entry.address, entry.public_key.size(), entry.encrypted_password.size());
+        } catch (const invalid_argument& e) {
+            invalid[i] = e.what();
+            continue;
+        }
+        if (!entry.created_time.empty() && !IsTimestamp(entry.created_time)) {
+            invalid[i] = "Invalid created_time";
+        }
+    }
 
-bool PasswordVault::CommitTransaction() {
-    return sqlite3_exec(db_, "COMMIT", nullptr, nullptr, nullptr) == SQLITE_OK;
-}
+    auto lock = database_.Lock();
+    vector<BatchResult> results;
+    results.reserve(entries.size());
 
-bool PasswordVault::RollbackTransaction() {
-    return sqlite3_exec(db_, "ROLLBACK", nullptr, nullptr, nullptr) == SQLITE_OK;
+    // revision、updated_time 与 sync_id 在语句里直接给出，插入触发器整批跳过，
+    // 密码本计数在提交前一次推进，不必每行各改一次 Codebook 与刚插入的行
+    const char* sql = R"(
+        INSERT INTO PasswordEntry 
+        (codebook_id, address, public_key, encrypted_password, notes, created_time,
+         updated_time, revision, sync_id)
+        VALUES (?, ?, ?, ?, ?, COALESCE(?, CURRENT_TIMESTAMP),
+                strftime('%Y-%m-%d %H:%M:%f', 'now'), ?, randomblob(16))
+    )";
+
+    if (!BeginTransaction()) {
+        throw runtime_error("Failed to start transaction");
+    }
+
+    try {
+        // 密码本不存在时从 0 起算，插入照常由外键拒绝
+        int64_t revision = 0;
+        {
+            Statement current = database_.Prepare("SELECT revision FROM Codebook WHERE codebook_id = ?");
+            sqlite3_bind_int(current, 1, codebook_id);
+            if (sqlite3_step(current) == SQLITE_ROW) {
+                revision = sqlite3_column_int64(current, 0);
+            }
+        }
+        int64_t first_revision = revision;
+
+        Statement stmt = database_.Prepare(sql);
+
+        for (size_t i = 0; i < entries.size(); ++i) {
+            const EntryInput& entry = entries[i];
+            if (!invalid[i].empty()) {
+                results.push_back({false, 0, invalid[i], WriteStatus::ConstraintFailed});
+                continue;
+            }
+            sqlite3_bind_int(stmt, 1, codebook_id);
+            sqlite3_bind_text(stmt, 2, entry.address.c_str(), -1, SQLITE_STATIC);
+            BindBytes(stmt, 3, AsBytes(entry.public_key));
+            BindBytes(stmt, 4, AsBytes(entry.encrypted_password));
+            sqlite3_bind_text(stmt, 5, entry.notes.c_str(), -1, SQLITE_STATIC);
+            // 未绑定的参数为 NULL，由 COALESCE 取当前时间
+            if (!entry.created_time.empty()) {
+                sqlite3_bind_text(stmt, 6, entry.created_time.c_str(), -1, SQLITE_STATIC);
+            }
+            sqlite3_bind_int64(stmt, 7, revision + 1);
+
+            // 约束失败只回滚当前语句，事务继续
+            int rc = sqlite3_step(stmt);
+            if (rc == SQLITE_DONE) {
+                ++revision;
+                results.push_back({true, static_cast<int>(sqlite3_last_insert_rowid(db_)), "", WriteStatus::Ok});
+            } else if (database_.StatusOf(rc) == WriteStatus::NotFound) {
+                // 外键失败说明密码本不存在；持有写锁期间它不会出现，其余行无需再试
+                while (results.size() < entries.size()) {
+                    results.push_back({false, 0, "Codebook does not exist", WriteStatus::NotFound});
+                }
+                break;
+            } else {
+                results.push_back({false, 0, sqlite3_errmsg(db_), database_.StatusOf(rc)});
+                if (sqlite3_get_autocommit(db_)) {
+                    throw runtime_error("Batch aborted: " + results.back().error);
+                }
+            }
+            sqlite3_reset(stmt);
+            sqlite3_clear_bindings(stmt);
+        }
+
+        if (revision != first_revision) {
+            Statement advance = database_.Prepare("UPDATE Codebook SET revision = ? WHERE codebook_id = ?");
+            sqlite3_bind_int64(advance, 1, revision);
+            sqlite3_bind_int(advance, 2, codebook_id);
+            if (sqlite3_step(advance) != SQLITE_DONE) {
+                throw runtime_error("Failed to advance codebook revision: " + string(sqlite3_errmsg(db_)));
+            }
+        }
+
+        if (!CommitTransaction()) {
+            throw runtime_error("Commit failed: " + string(sqlite3_errmsg(db_)));
+        }
+        return results;
+
+    } catch (...) {
+        RollbackTransaction();
+        throw;
+    }
 }
 
-bool PasswordVault::CheckCodebookExists(int codebook_id) {
-    const char* sql = "SELECT 1 FROM Codebook WHERE codebook_id = ?";
-    sqlite3_stmt* stmt;
-    
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        throw runtime_error("Prepare failed: " + string(sqlite3_errmsg(db_)));
+vector<PasswordVault::BatchResult> PasswordVault::UpdateEntries(int codebook_id,
+                                                                span<const EntryUpdate> updates)
+{
+    Metrics::ScopedTimer timer(Metrics::Op::VaultBatchWrite);
+    auto lock = database_.Lock();
+    vector<BatchResult> results;
+    results.reserve(updates.size());
+
+    if (!CheckCodebookExists(codebook_id)) {
+        for (const EntryUpdate& update : updates) {
+            results.push_back({false, update.entry_id, "Codebook does not exist", WriteStatus::NotFound});
+        }
+        return results;
+    }
+
+    // 限定 codebook_id，防止批量更新越界改到其他密码本
+    const char* sql = R"(
+        UPDATE PasswordEntry SET
+        address = ?,
+        public_key = ?,
+        encrypted_password = ?,
+        notes = ?
+        WHERE entry_id = ? AND codebook_id = ?
+        )";
+
+    if (!BeginTransaction()) {
+        throw runtime_error("Failed to start transaction");
+    }
+
+    try {
+        Statement stmt = database_.Prepare(sql);
+
+        for (const EntryUpdate& update : updates) {
+            const EntryInput& fields = update.fields;
+            try {
+                ValidateEntryFields(fields.address, fields.public_key.size(), fields.encrypted_password.size());
+            } catch (const invalid_argument& e) {
+                results.push_back({false, update.entry_id, e.what(), WriteStatus::ConstraintFailed});
+                continue;
+            }
+
+            sqlite3_bind_text(stmt, 1, fields.address.c_str(), -1, SQLITE_STATIC);
+            BindBytes(stmt, 2, AsBytes(fields.public_key));
+            BindBytes(stmt, 3, AsBytes(fields.encrypted_password));
+            sqlite3_bind_text(stmt, 4, fields.notes.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_int(stmt, 5, update.entry_id);
+            sqlite3_bind_int(stmt, 6, codebook_id);
+
+            int rc = sqlite3_step(stmt);
+            if (rc != SQLITE_DONE) {
+                results.push_back({false, update.entry_id, sqlite3_errmsg(db_), database_.StatusOf(rc)});
+                if (sqlite3_get_autocommit(db_)) {
+                    throw runtime_error("Batch aborted: " + results.back().error);
+                }
+            } else if (sqlite3_changes(db_) == 0) {
+                results.push_back({false, update.entry_id, "Entry does not exist", WriteStatus::NotFound});
+            } else {
+                results.push_back({true, update.entry_id, "", WriteStatus::Ok});
+            }
+            sqlite3_reset(stmt);
+            sqlite3_clear_bindings(stmt);
+        }
+
+        if (!CommitTransaction()) {
+            throw runtime_error("Commit failed: " + string(sqlite3_errmsg(db_)));
+        }
+        for (const BatchResult& result : results) {
+            if (result.success) {
+                InvalidateCachedEntry(result.entry_id);
+            }
+        }
+        return results;
+
+    } catch (...) {
+        RollbackTransaction();
+        throw;
     }
-    
-    sqlite3_bind_int(stmt, 1, codebook_id);
-    bool exists = (sqlite3_step(stmt) == SQLITE_ROW);
-    sqlite3_finalize(stmt);
-    
-    return exists;
 }
 
-bool PasswordVault::ValidateCodebookName(const string& name) {
-    // 名称长度1-100字符，允许字母、数字、空格和常用符号
+WriteResult PasswordVault::DeleteEntry(int entry_id) {
+    Metrics::ScopedTimer timer(Metrics::Op::VaultWrite);
+    auto lock = database_.Lock();
+    const char* sql = "DELETE FROM PasswordEntry WHERE entry_id = ?";
+    Statement stmt = database_.Prepare(sql);
+
+    sqlite3_bind_int(stmt, 1, entry_id);
+    int rc = sqlite3_step(stmt);
+    if (rc != SQLITE_DONE) {
+        return {database_.StatusOf(rc)};
+    }
+    if (sqlite3_changes(db_) == 0) {
+        return {WriteStatus::NotFound};
+    }
+    InvalidateCachedEntry(entry_id);
+    return {WriteStatus::Ok};
+}
+
+vector<PasswordVault::PasswordEntry> PasswordVault::SearchEntries(int codebook_id,
+                                                                const string& query,
+                                                                int limit)
+{
+    Metrics::ScopedTimer timer(Metrics::Op::VaultSearch);
+    string match = BuildSearchQuery(query);
+    if (match.empty() || limit <= 0) {
+        return {};
+    }
+
+    const char* sql = R"(
+        SELECT e.entry_id, e.address, e.public_key, e.encrypted_password, e.notes, e.created_time
+        FROM PasswordEntrySearch s
+        JOIN PasswordEntry e ON e.entry_id = s.rowid
+        WHERE PasswordEntrySearch MATCH ?
+        AND e.codebook_id = ?
+        ORDER BY bm25(PasswordEntrySearch, 2.0, 1.0)
+        LIMIT ?
+    )";
+
+    ConnectionPool::Lease reader = AcquireReader();
+    Statement stmt = reader->Prepare(sql);
+
+    sqlite3_bind_text(stmt, 1, match.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 2, codebook_id);
+    sqlite3_bind_int(stmt, 3, limit);
+
+    vector<PasswordEntry> entries;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        entries.push_back(ReadEntry(stmt));
+    }
+
+    Metrics::Add(Metrics::Counter::RowsRead, entries.size());
+    return entries;
+}
+
+bool PasswordVault::GetKdfHeader(int codebook_id, vector<uint8_t>& header) {
+    auto lock = database_.Lock();
+    const char* sql = "SELECT header FROM CodebookKdf WHERE codebook_id = ?";
+    Statement stmt = database_.Prepare(sql);
+
+    sqlite3_bind_int(stmt, 1, codebook_id);
+    if (sqlite3_step(stmt) != SQLITE_ROW) {
+        return false;
+    }
+
+    const uint8_t* data = static_cast<const uint8_t*>(sqlite3_column_blob(stmt, 0));
+    header.assign(data, data + sqlite3_column_bytes(stmt, 0));
+    return true;
+}
+
+WriteResult PasswordVault::SetKdfHeader(int codebook_id, const vector<uint8_t>& header) {
+    auto lock = database_.Lock();
+
+    // 已有头部时保持不变，避免并发解锁写出两份不同的盐
+    const char* sql = R"(
+        INSERT INTO CodebookKdf (codebook_id, header)
+        VALUES (?, ?)
+        ON CONFLICT(codebook_id) DO NOTHING
+    )";
+
+    Statement stmt = database_.Prepare(sql);
+
+    sqlite3_bind_int(stmt, 1, codebook_id);
+    sqlite3_bind_blob(stmt, 2, header.data(), static_cast<int>(header.size()), SQLITE_STATIC);
+
+    int rc = sqlite3_step(stmt);
+    if (rc != SQLITE_DONE) {
+        return {database_.StatusOf(rc)};
+    }
+    return {sqlite3_changes(db_) > 0 ? WriteStatus::Ok : WriteStatus::AlreadyExists};
+}
+
+bool PasswordVault::GetEncryptedPassword(int entry_id, vector<uint8_t>& blob) {
+    auto lock = database_.Lock();
+    const char* sql = "SELECT encrypted_password FROM PasswordEntry WHERE entry_id = ?";
+    Statement stmt = database_.Prepare(sql);
+
+    sqlite3_bind_int(stmt, 1, entry_id);
+    if (sqlite3_step(stmt) != SQLITE_ROW) {
+        return false;
+    }
+
+    const uint8_t* data = static_cast<const uint8_t*>(sqlite3_column_blob(stmt, 0));
+    blob.assign(data, data + sqlite3_column_bytes(stmt, 0));
+    return true;
+}
+
+bool PasswordVault::UpdateEncryptedPassword(int entry_id, span<const uint8_t> blob) {
+    auto lock = database_.Lock();
+    if (blob.empty() || blob.size() > 512) {
+        throw invalid_argument("Encrypted password is invalid");
+    }
+
+    const char* sql = "UPDATE PasswordEntry SET encrypted_password = ? WHERE entry_id = ?";
+    Statement stmt = database_.Prepare(sql);
+
+    sqlite3_bind_blob(stmt, 1, blob.data(), static_cast<int>(blob.size()), SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 2, entry_id);
+
+    bool success = sqlite3_step(stmt) == SQLITE_DONE;
+    int rowsAffected = sqlite3_changes(db_);
+    if (!success || rowsAffected == 0) {
+        return false;
+    }
+    InvalidateCachedEntry(entry_id);
+    return true;
+}
+
+size_t PasswordVault::ForEachEncryptedPassword(int codebook_id, const BlobVisitor& visitor) {
+    Metrics::ScopedTimer timer(Metrics::Op::VaultList);
+    const char* sql = R"(
+        SELECT entry_id, encrypted_password
+        FROM PasswordEntry
+        WHERE codebook_id = ?
+        ORDER BY entry_id
+    )";
+
+    ConnectionPool::Lease reader = AcquireReader();
+    Statement stmt = reader->Prepare(sql);
+
+    sqlite3_bind_int(stmt, 1, codebook_id);
+
+    size_t visited = 0;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        // 先取指针再取长度，避免 SQLite 做类型转换后指针失效
+        const uint8_t* data = static_cast<const uint8_t*>(sqlite3_column_blob(stmt, 1));
+        size_t size = static_cast<size_t>(sqlite3_column_bytes(stmt, 1));
+        ++visited;
+        if (!visitor(sqlite3_column_int(stmt, 0), span<const uint8_t>(data, size))) {
+            break;
+        }
+    }
+    Metrics::Add(Metrics::Counter::RowsRead, visited);
+    return visited;
+}
+
+bool PasswordVault::GetEntryBinary(int entry_id, BinaryEntry& entry) {
+    Metrics::ScopedTimer timer(Metrics::Op::VaultGet);
+    const char* sql = R"(
+        SELECT entry_id, address, public_key, encrypted_password, notes, created_time
+        FROM PasswordEntry
+        WHERE entry_id = ?
+    )";
+
+    ConnectionPool::Lease reader = AcquireReader();
+    Statement stmt = reader->Prepare(sql);
+
+    sqlite3_bind_int(stmt, 1, entry_id);
+    if (sqlite3_step(stmt) != SQLITE_ROW) {
+        return false;
+    }
+
+    entry.id = sqlite3_column_int(stmt, 0);
+    entry.address = ColumnText(stmt, 1);
+    span<const uint8_t> public_key = ColumnBytes(stmt, 2);
+    entry.public_key.assign(public_key.begin(), public_key.end());
+    span<const uint8_t> encrypted_password = ColumnBytes(stmt, 3);
+    entry.encrypted_password.assign(encrypted_password.begin(), encrypted_password.end());
+    entry.notes = ColumnText(stmt, 4);
+    entry.created_time = ColumnText(stmt, 5);
+    Metrics::Add(Metrics::Counter::RowsRead);
+    return true;
+}
+
+size_t PasswordVault::ForEachEntry(int codebook_id, const function<bool(const EntryView&)>& visitor) {
+    Metrics::ScopedTimer timer(Metrics::Op::VaultList);
+    const char* sql = R"(
+        SELECT entry_id, address, public_key, encrypted_password, notes, created_time
+        FROM PasswordEntry
+        WHERE codebook_id = ?
+        ORDER BY created_time DESC, entry_id DESC
+    )";
+
+    ConnectionPool::Lease reader = AcquireReader();
+    Statement stmt = reader->Prepare(sql);
+
+    sqlite3_bind_int(stmt, 1, codebook_id);
+
+    auto text = [&](int col) {
+        const char* data = reinterpret_cast<const char*>(sqlite3_column_text(stmt, col));
+        return data ? string_view(data, sqlite3_column_bytes(stmt, col)) : string_view();
+    };
+
+    size_t visited = 0;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        EntryView view;
+        view.id = sqlite3_column_int(stmt, 0);
+        view.address = text(1);
+        view.public_key = ColumnBytes(stmt, 2);
+        view.encrypted_password = ColumnBytes(stmt, 3);
+        view.notes = text(4);
+        view.created_time = text(5);
+        ++visited;
+        if (!visitor(view)) {
+            break;
+        }
+    }
+    Metrics::Add(Metrics::Counter::RowsRead, visited);
+    return visited;
+}
+
+int64_t PasswordVault::MigrateTextEncodedEntries(int batch_size) {
+    const char* select_sql = R"(
+        SELECT entry_id, typeof(encrypted_password) = 'text', encrypted_password
+        FROM PasswordEntry
+        WHERE entry_id > ?
+          AND (typeof(encrypted_password) = 'text' OR typeof(public_key) = 'text')
+        ORDER BY entry_id
+        LIMIT ?
+    )";
+    // 只改存储类型，内容不变：revision = -2 让更新触发器保留 revision 与 updated_time，
+    // 迁移后的行不会作为新编辑同步到其它副本
+    const char* update_sql = R"(
+        UPDATE PasswordEntry SET
+        encrypted_password = ?,
+        public_key = CAST(public_key AS BLOB),
+        revision = -2
+        WHERE entry_id = ?
+    )";
+
+    batch_size = max(batch_size, 1);
+    int64_t migrated = 0;
+    int last_entry_id = 0;
+    while (true) {
+        auto lock = database_.Lock();
+        if (!BeginTransaction()) {
+            throw runtime_error("Failed to start transaction");
+        }
+
+        try {
+            int rows = 0;
+            {
+                Statement select = database_.Prepare(select_sql);
+                Statement update = database_.Prepare(update_sql);
+                sqlite3_bind_int(select, 1, last_entry_id);
+                sqlite3_bind_int(select, 2, batch_size);
+
+                vector<uint8_t> decoded;
+                while (sqlite3_step(select) == SQLITE_ROW) {
+                    last_entry_id = sqlite3_column_int(select, 0);
+                    bool is_text = sqlite3_column_int(select, 1) != 0;
+                    span<const uint8_t> stored = ColumnBytes(select, 2);
+
+                    decoded.assign(stored.begin(), stored.end());
+                    if (is_text) {
+                        vector<uint8_t> binary;
+                        if (VaultEnvelope::decodeText(reinterpret_cast<const char*>(stored.data()),
+                                                      stored.size(), binary)) {
+                            decoded = move(binary);
+                        }
+                    }
+
+                    BindBytes(update, 1, decoded);
+                    sqlite3_bind_int(update, 2, last_entry_id);
+                    if (sqlite3_step(update) != SQLITE_DONE) {
+                        throw runtime_error("Migration failed: " + string(sqlite3_errmsg(db_)));
+                    }
+                    sqlite3_reset(update);
+                    ++rows;
+                }
+            }
+
+            if (!CommitTransaction()) {
+                throw runtime_error("Commit failed: " + string(sqlite3_errmsg(db_)));
+            }
+            migrated += rows;
+            if (rows > 0 && entry_cache_) {
+                entry_cache_->Clear();
+            }
+            if (rows < batch_size) {
+                return migrated;
+            }
+
+        } catch (...) {
+            RollbackTransaction();
+            throw;
+        }
+    }
+}
+
+int PasswordVault::CountEntries(int codebook_id) {
+    const char* sql = "SELECT COUNT(*) FROM PasswordEntry WHERE codebook_id = ?";
+
+    ConnectionPool::Lease reader = AcquireReader();
+    Statement stmt = reader->Prepare(sql);
+
+    sqlite3_bind_int(stmt, 1, codebook_id);
+    return sqlite3_step(stmt) == SQLITE_ROW ? sqlite3_column_int(stmt, 0) : 0;
+}
+
+vector<PasswordVault::EncryptedBlob> PasswordVault::GetEncryptedPasswordsAfter(int codebook_id,
+                                                                            int after_entry_id,
+                                                                            int limit)
+{
+    Metrics::ScopedTimer timer(Metrics::Op::VaultList);
+    const char* sql = R"(
+        SELECT entry_id, encrypted_password
+        FROM PasswordEntry
+        WHERE codebook_id = ? AND entry_id > ?
+        ORDER BY entry_id
+        LIMIT ?
+    )";
+
+    ConnectionPool::Lease reader = AcquireReader();
+    Statement stmt = reader->Prepare(sql);
+
+    sqlite3_bind_int(stmt, 1, codebook_id);
+    sqlite3_bind_int(stmt, 2, after_entry_id);
+    sqlite3_bind_int(stmt, 3, limit);
+
+    vector<EncryptedBlob> blobs;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const uint8_t* data = static_cast<const uint8_t*>(sqlite3_column_blob(stmt, 1));
+        size_t size = static_cast<size_t>(sqlite3_column_bytes(stmt, 1));
+        blobs.push_back({sqlite3_column_int(stmt, 0), vector<uint8_t>(data, data + size)});
+    }
+    Metrics::Add(Metrics::Counter::RowsRead, blobs.size());
+    return blobs;
+}
+
+WriteResult PasswordVault::BeginRotation(int codebook_id, const vector<uint8_t>& new_header) {
+    auto lock = database_.Lock();
+    {
+        Statement synced = database_.Prepare("SELECT synced FROM Codebook WHERE codebook_id = ?");
+        sqlite3_bind_int(synced, 1, codebook_id);
+        if (sqlite3_step(synced) == SQLITE_ROW && sqlite3_column_int(synced, 0) != 0) {
+            return {WriteStatus::ConstraintFailed};
+        }
+    }
+
+    const char* sql = R"(
+        INSERT INTO RotationCheckpoint (codebook_id, new_header)
+        VALUES (?, ?)
+        ON CONFLICT(codebook_id) DO NOTHING
+    )";
+
+    Statement stmt = database_.Prepare(sql);
+
+    sqlite3_bind_int(stmt, 1, codebook_id);
+    sqlite3_bind_blob(stmt, 2, new_header.data(), static_cast<int>(new_header.size()), SQLITE_STATIC);
+
+    int rc = sqlite3_step(stmt);
+    if (rc != SQLITE_DONE) {
+        return {database_.StatusOf(rc)};
+    }
+    return {sqlite3_changes(db_) > 0 ? WriteStatus::Ok : WriteStatus::AlreadyExists};
+}
+
+void PasswordVault::JoinSync(int codebook_id) {
+    Statement rotating = database_.Prepare("SELECT 1 FROM RotationCheckpoint WHERE codebook_id = ?");
+    sqlite3_bind_int(rotating, 1, codebook_id);
+    if (sqlite3_step(rotating) == SQLITE_ROW) {
+        throw logic_error("Codebook is being rotated");
+    }
+
+    Statement mark = database_.Prepare("UPDATE Codebook SET synced = 1 WHERE codebook_id = ? AND synced = 0");
+    sqlite3_bind_int(mark, 1, codebook_id);
+    if (sqlite3_step(mark) != SQLITE_DONE) {
+        throw runtime_error("Failed to mark codebook as synced: " + string(sqlite3_errmsg(db_)));
+    }
+}
+
+bool PasswordVault::GetRotationCheckpoint(int codebook_id, RotationCheckpoint& checkpoint) {
+    auto lock = database_.Lock();
+    const char* sql = R"(
+        SELECT new_header, last_entry_id, processed
+        FROM RotationCheckpoint
+        WHERE codebook_id = ?
+    )";
+    Statement stmt = database_.Prepare(sql);
+
+    sqlite3_bind_int(stmt, 1, codebook_id);
+    if (sqlite3_step(stmt) != SQLITE_ROW) {
+        return false;
+    }
+
+    const uint8_t* data = static_cast<const uint8_t*>(sqlite3_column_blob(stmt, 0));
+    checkpoint.new_header.assign(data, data + sqlite3_column_bytes(stmt, 0));
+    checkpoint.last_entry_id = sqlite3_column_int(stmt, 1);
+    checkpoint.processed = sqlite3_column_int64(stmt, 2);
+    return true;
+}
+
+vector<int> PasswordVault::ApplyRotationBatch(int codebook_id,
+                                              span<const BlobRewrite> rewrites,
+                                              int last_entry_id,
+                                              int64_t processed)
+{
+    auto lock = database_.Lock();
+
+    // 比较并交换：密文在读取后被改写（仍是旧密钥加密的新内容）时不覆盖。
+    // 旧接口以 TEXT 写入的密文需转成 BLOB 再比较
+    const char* update_sql = R"(
+        UPDATE PasswordEntry SET encrypted_password = ?
+        WHERE entry_id = ? AND codebook_id = ? AND CAST(encrypted_password AS BLOB) = ?
+    )";
+    const char* checkpoint_sql = R"(
+        UPDATE RotationCheckpoint SET last_entry_id = ?, processed = ?
+        WHERE codebook_id = ?
+    )";
+
+    if (!BeginTransaction()) {
+        throw runtime_error("Failed to start transaction");
+    }
+
+    try {
+        vector<int> conflicts;
+        Statement update = database_.Prepare(update_sql);
+
+        for (const BlobRewrite& rewrite : rewrites) {
+            if (rewrite.new_blob.empty() || rewrite.new_blob.size() > 512) {
+                throw invalid_argument("Encrypted password is invalid");
+            }
+            sqlite3_bind_blob(update, 1, rewrite.new_blob.data(), static_cast<int>(rewrite.new_blob.size()), SQLITE_STATIC);
+            sqlite3_bind_int(update, 2, rewrite.entry_id);
+            sqlite3_bind_int(update, 3, codebook_id);
+            sqlite3_bind_blob(update, 4, rewrite.old_blob.data(), static_cast<int>(rewrite.old_blob.size()), SQLITE_STATIC);
+
+            if (sqlite3_step(update) != SQLITE_DONE) {
+                throw runtime_error("Rotation write failed: " + string(sqlite3_errmsg(db_)));
+            }
+            if (sqlite3_changes(db_) == 0) {
+                conflicts.push_back(rewrite.entry_id);
+            }
+            sqlite3_reset(update);
+        }
+
+        if (conflicts.empty()) {
+            Statement checkpoint = database_.Prepare(checkpoint_sql);
+            sqlite3_bind_int(checkpoint, 1, last_entry_id);
+            sqlite3_bind_int64(checkpoint, 2, processed);
+            sqlite3_bind_int(checkpoint, 3, codebook_id);
+            if (sqlite3_step(checkpoint) != SQLITE_DONE) {
+                throw runtime_error("Failed to save rotation checkpoint: " + string(sqlite3_errmsg(db_)));
+            }
+        }
+
+        if (!CommitTransaction()) {
+            throw runtime_error("Commit failed: " + string(sqlite3_errmsg(db_)));
+        }
+        InvalidateCachedCodebook(codebook_id);
+        return conflicts;
+
+    } catch (...) {
+        RollbackTransaction();
+        throw;
+    }
+}
+
+bool PasswordVault::FinishRotation(int codebook_id) {
+    auto lock = database_.Lock();
+
+    const char* pending_sql = R"(
+        SELECT EXISTS (
+            SELECT 1 FROM PasswordEntry
+            WHERE codebook_id = ?1
+              AND entry_id > (SELECT last_entry_id FROM RotationCheckpoint WHERE codebook_id = ?1)
+        )
+    )";
+    const char* header_sql = R"(
+        INSERT INTO CodebookKdf (codebook_id, header)
+        SELECT codebook_id, new_header FROM RotationCheckpoint WHERE codebook_id = ?
+        ON CONFLICT(codebook_id) DO UPDATE SET header = excluded.header
+    )";
+    const char* clear_sql = "DELETE FROM RotationCheckpoint WHERE codebook_id = ?";
+
+    if (!BeginTransaction()) {
+        throw runtime_error("Failed to start transaction");
+    }
+
+    try {
+        Statement pending = database_.Prepare(pending_sql);
+        sqlite3_bind_int(pending, 1, codebook_id);
+        if (sqlite3_step(pending) != SQLITE_ROW) {
+            throw runtime_error("Failed to check rotation progress: " + string(sqlite3_errmsg(db_)));
+        }
+        bool finished = sqlite3_column_int(pending, 0) == 0;
+
+        if (finished) {
+            Statement header = database_.Prepare(header_sql);
+            sqlite3_bind_int(header, 1, codebook_id);
+            if (sqlite3_step(header) != SQLITE_DONE || sqlite3_changes(db_) == 0) {
+                throw runtime_error("No rotation in progress for this codebook");
+            }
+
+            Statement clear = database_.Prepare(clear_sql);
+            sqlite3_bind_int(clear, 1, codebook_id);
+            if (sqlite3_step(clear) != SQLITE_DONE) {
+                throw runtime_error("Failed to clear rotation checkpoint: " + string(sqlite3_errmsg(db_)));
+            }
+        }
+
+        if (!CommitTransaction()) {
+            throw runtime_error("Commit failed: " + string(sqlite3_errmsg(db_)));
+        }
+        return finished;
+
+    } catch (...) {
+        RollbackTransaction();
+        throw;
+    }
+}
+
+bool PasswordVault::GetChangesSince(int codebook_id, int64_t revision, ChangeSet& changes, int limit) {
+    Metrics::ScopedTimer timer(Metrics::Op::VaultList);
+    if (limit <= 0) {
+        throw invalid_argument("Limit must be positive");
+    }
+
+    // 两路各走 idx_entry_revision / idx_tombstone_revision，只读 revision 之后的行
+    const char* sql = R"(
+        SELECT sync_id, revision, updated_time, 0,
+               address, public_key, encrypted_password, notes, created_time
+        FROM PasswordEntry
+        WHERE codebook_id = ?1 AND revision > ?2
+        UNION ALL
+        SELECT sync_id, revision, deleted_time, 1, NULL, NULL, NULL, NULL, NULL
+        FROM EntryTombstone
+        WHERE codebook_id = ?1 AND revision > ?2
+        ORDER BY 2
+        LIMIT ?3
+    )";
+
+    ConnectionPool::Lease reader = AcquireReader();
+    {
+        Statement exists = reader->Prepare("SELECT synced FROM Codebook WHERE codebook_id = ?");
+        sqlite3_bind_int(exists, 1, codebook_id);
+        if (sqlite3_step(exists) != SQLITE_ROW) {
+            return false;
+        }
+        // 只有首次导出需要写库
+        if (sqlite3_column_int(exists, 0) == 0) {
+            auto lock = database_.Lock();
+            JoinSync(codebook_id);
+        }
+    }
+
+    changes.revision = revision;
+    changes.more = false;
+    changes.kdf_header.clear();
+    changes.changes.clear();
+    {
+        Statement header = reader->Prepare("SELECT header FROM CodebookKdf WHERE codebook_id = ?");
+        sqlite3_bind_int(header, 1, codebook_id);
+        if (sqlite3_step(header) == SQLITE_ROW) {
+            span<const uint8_t> bytes = ColumnBytes(header, 0);
+            changes.kdf_header.assign(bytes.begin(), bytes.end());
+        }
+    }
+
+    Statement stmt = reader->Prepare(sql);
+    sqlite3_bind_int(stmt, 1, codebook_id);
+    sqlite3_bind_int64(stmt, 2, revision);
+    sqlite3_bind_int(stmt, 3, limit);
+
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        EntryChange change;
+        change.sync_id = ColumnText(stmt, 0);
+        change.revision = sqlite3_column_int64(stmt, 1);
+        change.updated_time = ColumnText(stmt, 2);
+        change.deleted = sqlite3_column_int(stmt, 3) != 0;
+        if (!change.deleted) {
+            change.fields.address = ColumnText(stmt, 4);
+            change.fields.public_key = ColumnText(stmt, 5);
+            change.fields.encrypted_password = ColumnText(stmt, 6);
+            change.fields.notes = ColumnText(stmt, 7);
+            change.fields.created_time = ColumnText(stmt, 8);
+        }
+        changes.revision = change.revision;
+        changes.changes.push_back(move(change));
+    }
+    changes.more = changes.changes.size() == static_cast<size_t>(limit);
+    Metrics::Add(Metrics::Counter::RowsRead, changes.changes.size());
+    return true;
+}
+
+WriteResult PasswordVault::ApplyChanges(int codebook_id, const ChangeSet& changes, ApplyStats* stats) {
+    Metrics::ScopedTimer timer(Metrics::Op::VaultBatchWrite);
+
+    // 先校验全部输入，进入事务后只会因数据库错误失败
+    for (const EntryChange& change : changes.changes) {
+        if (change.sync_id.size() != SYNC_ID_SIZE || !IsChangeTimestamp(change.updated_time)) {
+            throw invalid_argument("Invalid change record");
+        }
+        if (!change.deleted) {
+            ValidateEntryFields(change.fields.address,
+                                change.fields.public_key.size(),
+                                change.fields.encrypted_password.size());
+            if (!change.fields.created_time.empty() && !IsTimestamp(change.fields.created_time)) {
+                throw invalid_argument("Invalid created_time");
+            }
+        }
+    }
+
+    const char* find_entry_sql = R"(
+        SELECT entry_id, updated_time, encrypted_password FROM PasswordEntry
+        WHERE codebook_id = ? AND sync_id = ?
+    )";
+    const char* find_tombstone_sql = "SELECT deleted_time FROM EntryTombstone WHERE codebook_id = ? AND sync_id = ?";
+    const char* insert_sql = R"(
+        INSERT INTO PasswordEntry
+        (codebook_id, address, public_key, encrypted_password, notes, created_time, updated_time, sync_id)
+        VALUES (?, ?, ?, ?, ?, COALESCE(?, CURRENT_TIMESTAMP), ?, ?)
+    )";
+    // revision = -1 让更新触发器保留来源的 updated_time，触发器随后写入本地 revision
+    const char* update_sql = R"(
+        UPDATE PasswordEntry
+        SET address = ?, public_key = ?, encrypted_password = ?, notes = ?, updated_time = ?, revision = -1
+        WHERE entry_id = ?
+    )";
+    const char* delete_sql = "DELETE FROM PasswordEntry WHERE entry_id = ?";
+    // 删除触发器记下的是本地时间，改回来源的删除时间，各副本的裁决才一致
+    const char* stamp_sql = "UPDATE EntryTombstone SET deleted_time = ? WHERE codebook_id = ? AND sync_id = ?";
+    // 本地从未有过的条目也留墓碑，经本副本中转的其它副本才能收到这次删除；
+    // 已有墓碑（两边都删除过）时改为较晚的删除时间并重新编号
+    const char* bump_sql = "UPDATE Codebook SET revision = revision + 1 WHERE codebook_id = ?";
+    const char* tombstone_sql = R"(
+        INSERT INTO EntryTombstone (codebook_id, sync_id, revision, deleted_time)
+        SELECT codebook_id, ?, revision, ? FROM Codebook WHERE codebook_id = ?
+        ON CONFLICT(codebook_id, sync_id) DO UPDATE
+        SET revision = excluded.revision, deleted_time = excluded.deleted_time
+    )";
+
+    auto lock = database_.Lock();
+    ApplyStats result{0, 0, 0};
+    vector<int> touched;
+
+    if (!BeginTransaction()) {
+        throw runtime_error("Failed to start transaction");
+    }
+
+    try {
+        Statement revision = database_.Prepare("SELECT revision FROM Codebook WHERE codebook_id = ?");
+        sqlite3_bind_int(revision, 1, codebook_id);
+        if (sqlite3_step(revision) != SQLITE_ROW) {
+            RollbackTransaction();
+            return {WriteStatus::NotFound};
+        }
+        sqlite3_reset(revision);
+        JoinSync(codebook_id);
+
+        if (!changes.kdf_header.empty()) {
+            vector<uint8_t> local;
+            if (!GetKdfHeader(codebook_id, local)) {
+                WriteResult adopted = SetKdfHeader(codebook_id, changes.kdf_header);
+                if (!adopted) {
+                    throw runtime_error("Failed to store KDF header");
+                }
+            } else if (local != changes.kdf_header) {
+                throw invalid_argument("KDF header does not match the local codebook");
+            }
+        }
+
+        Statement find_entry = database_.Prepare(find_entry_sql);
+        Statement find_tombstone = database_.Prepare(find_tombstone_sql);
+        Statement insert = database_.Prepare(insert_sql);
+        Statement update = database_.Prepare(update_sql);
+        Statement remove = database_.Prepare(delete_sql);
+        Statement stamp = database_.Prepare(stamp_sql);
+        Statement bump = database_.Prepare(bump_sql);
+        Statement tombstone = database_.Prepare(tombstone_sql);
+
+        auto run = [&](Statement& stmt) {
+            int rc = sqlite3_step(stmt);
+            sqlite3_reset(stmt);
+            sqlite3_clear_bindings(stmt);
+            if (rc != SQLITE_DONE) {
+                throw runtime_error("Failed to apply change: " + string(sqlite3_errmsg(db_)));
+            }
+        };
+        auto bindSyncId = [](Statement& stmt, int index, const string& sync_id) {
+            sqlite3_bind_blob(stmt, index, sync_id.data(), static_cast<int>(sync_id.size()), SQLITE_STATIC);
+        };
+
+        for (const EntryChange& change : changes.changes) {
+            sqlite3_bind_int(find_entry, 1, codebook_id);
+            bindSyncId(find_entry, 2, change.sync_id);
+            bool found = sqlite3_step(find_entry) == SQLITE_ROW;
+            int entry_id = 0;
+            string local_time;
+            string local_blob;
+            if (found) {
+                entry_id = sqlite3_column_int(find_entry, 0);
+                local_time = ColumnText(find_entry, 1);
+                local_blob = ColumnText(find_entry, 2);
+            }
+            sqlite3_reset(find_entry);
+
+            bool buried = false;
+            if (!found) {
+                sqlite3_bind_int(find_tombstone, 1, codebook_id);
+                bindSyncId(find_tombstone, 2, change.sync_id);
+                buried = sqlite3_step(find_tombstone) == SQLITE_ROW;
+                if (buried) {
+                    local_time = ColumnText(find_tombstone, 0);
+                }
+                sqlite3_reset(find_tombstone);
+            }
+
+            if ((found || buried) &&
+                !ChangeWins(change.updated_time, change.deleted, change.fields.encrypted_password,
+                            local_time, buried, local_blob)) {
+                ++result.skipped;
+                continue;
+            }
+
+            if (change.deleted) {
+                if (found) {
+                    sqlite3_bind_int(remove, 1, entry_id);
+                    run(remove);
+                    sqlite3_bind_text(stamp, 1, change.updated_time.c_str(), -1, SQLITE_STATIC);
+                    sqlite3_bind_int(stamp, 2, codebook_id);
+                    bindSyncId(stamp, 3, change.sync_id);
+                    run(stamp);
+                    touched.push_back(entry_id);
+                } else {
+                    sqlite3_bind_int(bump, 1, codebook_id);
+                    run(bump);
+                    bindSyncId(tombstone, 1, change.sync_id);
+                    sqlite3_bind_text(tombstone, 2, change.updated_time.c_str(), -1, SQLITE_STATIC);
+                    sqlite3_bind_int(tombstone, 3, codebook_id);
+                    run(tombstone);
+                }
+            } else if (found) {
+                const EntryInput& fields = change.fields;
+                sqlite3_bind_text(update, 1, fields.address.c_str(), -1, SQLITE_STATIC);
+                BindBytes(update, 2, AsBytes(fields.public_key));
+                BindBytes(update, 3, AsBytes(fields.encrypted_password));
+                sqlite3_bind_text(update, 4, fields.notes.c_str(), -1, SQLITE_STATIC);
+                sqlite3_bind_text(update, 5, change.updated_time.c_str(), -1, SQLITE_STATIC);
+                sqlite3_bind_int(update, 6, entry_id);
+                run(update);
+                touched.push_back(entry_id);
+            } else {
+                // 插入触发器会删除同一 sync_id 的墓碑
+                const EntryInput& fields = change.fields;
+                sqlite3_bind_int(insert, 1, codebook_id);
+                sqlite3_bind_text(insert, 2, fields.address.c_str(), -1, SQLITE_STATIC);
+                BindBytes(insert, 3, AsBytes(fields.public_key));
+                BindBytes(insert, 4, AsBytes(fields.encrypted_password));
+                sqlite3_bind_text(insert, 5, fields.notes.c_str(), -1, SQLITE_STATIC);
+                if (!fields.created_time.empty()) {
+                    sqlite3_bind_text(insert, 6, fields.created_time.c_str(), -1, SQLITE_STATIC);
+                }
+                sqlite3_bind_text(insert, 7, change.updated_time.c_str(), -1, SQLITE_STATIC);
+                bindSyncId(insert, 8, change.sync_id);
+                run(insert);
+            }
+            ++result.applied;
+        }
+
+        sqlite3_bind_int(revision, 1, codebook_id);
+        if (sqlite3_step(revision) != SQLITE_ROW) {
+            throw runtime_error("Failed to read codebook revision: " + string(sqlite3_errmsg(db_)));
+        }
+        result.revision = sqlite3_column_int64(revision, 0);
+        sqlite3_reset(revision);
+
+        if (!CommitTransaction()) {
+            throw runtime_error("Commit failed: " + string(sqlite3_errmsg(db_)));
+        }
+
+    } catch (...) {
+        RollbackTransaction();
+        throw;
+    }
+
+    for (int entry_id : touched) {
+        InvalidateCachedEntry(entry_id);
+    }
+    if (stats) {
+        *stats = result;
+    }
+    return {WriteStatus::Ok};
+}
+
+size_t PasswordVault::PruneTombstones(int codebook_id, int64_t revision) {
+    auto lock = database_.Lock();
+    const char* sql = "DELETE FROM EntryTombstone WHERE codebook_id = ? AND revision <= ?";
+    Statement stmt = database_.Prepare(sql);
+
+    sqlite3_bind_int(stmt, 1, codebook_id);
+    sqlite3_bind_int64(stmt, 2, revision);
+    if (sqlite3_step(stmt) != SQLITE_DONE) {
+        throw runtime_error("Failed to prune tombstones: " + string(sqlite3_errmsg(db_)));
+    }
+    return static_cast<size_t>(sqlite3_changes(db_));
+}
+
+// 事务处理方法
+bool PasswordVault::BeginTransaction() {
+    return database_.BeginTransaction();
+}
+
+bool PasswordVault::CommitTransaction() {
+    return database_.CommitTransaction();
+}
+
+bool PasswordVault::RollbackTransaction() {
+    return database_.RollbackTransaction();
+}
+
+bool PasswordVault::CheckCodebookExists(int codebook_id) {
+    auto lock = database_.Lock();
+    const char* sql = "SELECT 1 FROM Codebook WHERE codebook_id = ?";
+    Statement stmt = database_.Prepare(sql);
+    
+    sqlite3_bind_int(stmt, 1, codebook_id);
+    bool exists = (sqlite3_step(stmt) == SQLITE_ROW);
+    
+    return exists;
+}
+
+bool PasswordVault::ValidateCodebookName(const string& name) {
+    // 名称长度1-100字符，允许字母、数字、空格和常用符号
     return !name.empty() && 
           name.length() <= 100 &&
           all_of(name.begin(), name.end(), [](char c) {
               return isalnum(c) || c == ' ' || c == '-' || c == '_';
           });
+}
+
+void PasswordVault::ValidateEntryFields(const string& address,
+                                        size_t public_key_size,
+                                        size_t encrypted_password_size) {
+    if (address.empty() || address.length() > 253) {
+        throw invalid_argument("Address must be 1-253 characters");
+    }
+    if (public_key_size == 0 || public_key_size > 4096) {
+        throw invalid_argument("Public key is invalid");
+    }
+    if (encrypted_password_size == 0 || encrypted_password_size > 512) {
+        throw invalid_argument("Encrypted password is invalid");
+    }
 }
\ No newline at end of file
@@ -2,7 +2,24 @@
 #include <sqlite3.h>
 #include <vector>
 #include <string>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <functional>
+#include <string_view>
+#include "Database.h"
+#include "ConnectionPool.h"
 
+class EntryCache;
+class UserCache;
+
+// 并发模型：
+//  - 写：所有写操作与事务经由 Database 的单写者队列（FIFO、可重入）串行执行；
+//    事务从开启到提交/回滚都持有写锁，只属于开启它的线程。
+//  - 读：列表与检索查询从只读连接池借连接并行执行，互不阻塞，也不等待写事务；
+//    未提供连接池时退化为在写连接上排队。
+// 因此同一个 PasswordVault 可由工作线程池共享。通过 sqlite3* 构造的实例
+// 使用私有语句缓存，不与其他实例同步，只应在单线程中使用。
 class PasswordVault {
 public:
     struct Codebook {
@@ -20,36 +37,246 @@ public:
         std::string created_time;
     };
 
+    // public_key 与 encrypted_password 按原始字节返回，无需 hex/base64 编码
+    struct BinaryEntry {
+        int id;
+        std::string address;
+        std::vector<uint8_t> public_key;
+        std::vector<uint8_t> encrypted_password;
+        std::string notes;
+        std::string created_time;
+    };
+
+    // ForEachEntry 的只读视图，直接指向当前行，只在回调内有效
+    struct EntryView {
+        int id;
+        std::string_view address;
+        std::span<const uint8_t> public_key;
+        std::span<const uint8_t> encrypted_password;
+        std::string_view notes;
+        std::string_view created_time;
+    };
+
+    // 列表视图只需要的列，不读公钥、密文与备注
+    struct EntrySummary {
+        int id;
+        std::string address;
+        std::string created_time;
+    };
+
+    // 批量写入的单行输入
+    struct EntryInput {
+        std::string address;
+        std::string public_key;
+        std::string encrypted_password;
+        std::string notes;
+        std::string created_time;   // 仅 AddEntries 使用：为空取当前时间，否则须为 YYYY-MM-DD HH:MM:SS
+    };
+
+    struct EntryUpdate {
+        int entry_id;
+        EntryInput fields;
+    };
+
+    // 批量操作的逐行结果，失败行不影响同批其他行提交。
+    // 调用方按 status 区分失败原因，error 只供展示：NotFound 在 AddEntries 中
+    // 表示密码本不存在，在 UpdateEntries 中表示密码本或条目不存在；
+    // 字段校验失败为 ConstraintFailed
+    struct BatchResult {
+        bool success;
+        int entry_id;
+        std::string error;
+        WriteStatus status;
+    };
+
+    // 按 entry_id 顺序读出的单条密文
+    struct EncryptedBlob {
+        int entry_id;
+        std::vector<uint8_t> blob;
+    };
+
+    // 轮换写回：只有密文仍等于 old_blob 时才替换为 new_blob
+    struct BlobRewrite {
+        int entry_id;
+        std::vector<uint8_t> old_blob;
+        std::vector<uint8_t> new_blob;
+    };
+
+    // 增量同步的单条变更。条目在各副本上的 entry_id 不同，以 sync_id 对应
+    struct EntryChange {
+        std::string sync_id;        // 16 字节
+        int64_t revision;           // 来源副本上的 revision
+        std::string updated_time;   // YYYY-MM-DD HH:MM:SS.SSS；删除时为删除时间
+        bool deleted;
+        EntryInput fields;          // deleted 时为空
+    };
+
+    struct ChangeSet {
+        int64_t revision;                  // 下一次 GetChangesSince 传入的值
+        bool more;                         // 达到 limit，后面还有变更
+        std::vector<uint8_t> kdf_header;   // 来源密码本的 KDF 头，没有时为空
+        std::vector<EntryChange> changes;  // 按 revision 升序
+    };
+
+    struct ApplyStats {
+        size_t applied;     // 写入本地的变更
+        size_t skipped;     // 本地版本更新或相同而被忽略
+        int64_t revision;   // 应用后本地密码本的 revision
+    };
+
+    // 主密码轮换的断点：新 KDF 头与已完成到的 entry_id，崩溃后据此续跑
+    struct RotationCheckpoint {
+        std::vector<uint8_t> new_header;
+        int last_entry_id;
+        int64_t processed;
+    };
+
     explicit PasswordVault(sqlite3* db);
+    // 共享连接自身的语句缓存（UserAuth::GetDatabase()）；
+    // 传入 UserAuth::GetReadPool() 时列表与检索类查询走只读连接
+    explicit PasswordVault(Database& database, ConnectionPool* readers = nullptr);
+
+    // 可选的条目缓存（见 EntryCache）：GetEntryDetail 先查缓存，更新、删除条目与删除密码本
+    // 成功后失效对应项。共享同一缓存的实例必须指向同一个数据库
+    void SetEntryCache(std::shared_ptr<EntryCache> cache);
+    EntryCache* GetEntryCache() const { return entry_cache_.get(); }
+    // 通常传入 UserAuth::GetUserCache()：同时启用密码本列表缓存，GetUserCodebooks 从缓存返回，
+    // 新建/删除密码本在事务提交后同步更新
+    void SetUserCache(std::shared_ptr<UserCache> cache);
     
     // 密码本操作
-    bool CreateCodebook(const std::string& username, const std::string& name);
-    bool DeleteCodebook(int codebook_id);
+    // 写操作返回 WriteResult：NotFound 表示用户/密码本/条目不存在，AlreadyExists 表示重名，
+    // 新建成功时 id 为新行 id
+    WriteResult CreateCodebook(const std::string& username, const std::string& name);
+    // 条目、KDF 头与轮换检查点由外键级联删除
+    WriteResult DeleteCodebook(int codebook_id);
     std::vector<Codebook> GetUserCodebooks(const std::string& username);
 
     // 密码条目操作
-    bool AddEntry(int codebook_id, 
+    WriteResult AddEntry(int codebook_id, 
                 const std::string& address,
                 const std::string& public_key,
                 const std::string& encrypted_password,
                 const std::string& notes = "");
-    bool UpdateEntry(int entry_id,
+    WriteResult UpdateEntry(int entry_id,
                    const std::string& new_address,
                    const std::string& new_public_key,
                    const std::string& new_encrypted_password,
                    const std::string& new_notes);
-    bool DeleteEntry(int entry_id);
+    WriteResult DeleteEntry(int entry_id);
+
+    // 二进制接口：密文与公钥以 BLOB 绑定。上面的 std::string 重载同样按字节写入 BLOB
+    WriteResult AddEntryBinary(int codebook_id,
+                               const std::string& address,
+                               std::span<const uint8_t> public_key,
+                               std::span<const uint8_t> encrypted_password,
+                               const std::string& notes = "");
+    WriteResult UpdateEntryBinary(int entry_id,
+                                  const std::string& new_address,
+                                  std::span<const uint8_t> new_public_key,
+                                  std::span<const uint8_t> new_encrypted_password,
+                                  const std::string& new_notes);
+    bool GetEntryBinary(int entry_id, BinaryEntry& entry);
+    // 回调返回 false 提前结束，返回已访问的行数
+    size_t ForEachEntry(int codebook_id, const std::function<bool(const EntryView&)>& visitor);
+
+    // 把旧版以 TEXT 保存的 hex/base64 密文解码为 BLOB（无法识别的原样转为 BLOB），
+    // 公钥只转换存储类型不解码。分批提交，可重复执行；返回本次迁移的行数
+    int64_t MigrateTextEncodedEntries(int batch_size = 500);
+
+    // 批量操作：只检查一次密码本，单事务、复用同一预编译语句
+    std::vector<BatchResult> AddEntries(int codebook_id, std::span<const EntryInput> entries);
+    std::vector<BatchResult> UpdateEntries(int codebook_id, std::span<const EntryUpdate> updates);
     std::vector<PasswordEntry> GetEntries(int codebook_id, 
                                         const std::string& filter = "",
                                         int page = 0,
                                         int page_size = 50);
+    // 游标（keyset）分页：cursor 为空取第一页；next_cursor 为空表示没有更多数据。
+    // 深页与首页代价相同，由 idx_entry_summary 覆盖排序
+    std::vector<PasswordEntry> GetEntriesAfter(int codebook_id,
+                                             const std::string& cursor,
+                                             std::string& next_cursor,
+                                             int page_size = 50,
+                                             const std::string& filter = "");
+
+    // 与 GetEntriesAfter 相同的游标分页，只返回摘要列，完全由 idx_entry_summary 覆盖；
+    // 详情按需调用 GetEntryDetail 加载
+    std::vector<EntrySummary> ListEntrySummaries(int codebook_id,
+                                                 const std::string& cursor,
+                                                 std::string& next_cursor,
+                                                 int page_size = 50,
+                                                 const std::string& filter = "");
+    bool GetEntryDetail(int entry_id, PasswordEntry& entry);
+
+    // 全文检索 address 与 notes：按词前缀匹配，结果按 bm25 相关度排序（地址命中权重更高）
+    std::vector<PasswordEntry> SearchEntries(int codebook_id,
+                                           const std::string& query,
+                                           int limit = 50);
+
+    // 密码本级 KDF 头（VaultEnvelope 格式），每个密码本只存一份
+    bool GetKdfHeader(int codebook_id, std::vector<uint8_t>& header);
+    WriteResult SetKdfHeader(int codebook_id, const std::vector<uint8_t>& header);
+
+    // 以二进制读写单条密文，供信封迁移使用
+    bool GetEncryptedPassword(int entry_id, std::vector<uint8_t>& blob);
+    bool UpdateEncryptedPassword(int entry_id, std::span<const uint8_t> blob);
+
+    // 逐行把密文以 span 形式交给回调，直接指向 sqlite3_column_blob，不经 std::string 拷贝；
+    // span 只在回调内有效。回调返回 false 提前结束，返回已访问的行数
+    using BlobVisitor = std::function<bool(int entry_id, std::span<const uint8_t> blob)>;
+    size_t ForEachEncryptedPassword(int codebook_id, const BlobVisitor& visitor);
+
+    int CountEntries(int codebook_id);
+    // entry_id 大于 after_entry_id 的前 limit 条密文，按 entry_id 升序；
+    // 轮换期间新增的条目 id 更大，仍会被扫描到
+    std::vector<EncryptedBlob> GetEncryptedPasswordsAfter(int codebook_id, int after_entry_id, int limit);
+
+    // 轮换检查点。BeginRotation 在已有检查点时保持不变，调用方应读回实际保存的头部；
+    // 参与过同步的密码本返回 ConstraintFailed：新头部无法传播到其它副本，轮换后双方会互相拒绝变更集
+    WriteResult BeginRotation(int codebook_id, const std::vector<uint8_t>& new_header);
+    bool GetRotationCheckpoint(int codebook_id, RotationCheckpoint& checkpoint);
+    // 单事务写入一批新密文并推进检查点。读取后被并发改写的行不会被覆盖，
+    // 其 entry_id 被返回，此时检查点不推进，由调用方重读重试
+    std::vector<int> ApplyRotationBatch(int codebook_id,
+                                        std::span<const BlobRewrite> rewrites,
+                                        int last_entry_id,
+                                        int64_t processed);
+    // 检查点之后已无条目时，在同一事务中启用新 KDF 头并删除检查点；否则返回 false
+    bool FinishRotation(int codebook_id);
+
+    // 增量同步：条目的新增、修改、删除都使密码本 revision 单调递增（触发器维护），
+    // 删除留下墓碑。GetChangesSince 返回 revision 之后的前 limit 条变更，代价只与变更数有关；
+    // 密码本不存在时返回 false。GetChangesSince 与 ApplyChanges 把密码本标记为参与同步，
+    // 此后不能再轮换主密码（见 BeginRotation）；轮换进行中时两者抛出 logic_error
+    bool GetChangesSince(int codebook_id, int64_t revision, ChangeSet& changes, int limit = 1000);
+    // 单事务应用另一副本的变更，按 updated_time 后写者胜（时间相同时删除优先，其次比较密文），
+    // 各副本以任意顺序互相拉取后收敛。本地没有 KDF 头时采用来源的头部，头部不同抛出 invalid_argument
+    WriteResult ApplyChanges(int codebook_id, const ChangeSet& changes, ApplyStats* stats = nullptr);
+    // 删除 revision 不大于给定值的墓碑；同步进度落后于此的副本将收不到这些删除
+    size_t PruneTombstones(int codebook_id, int64_t revision);
 
 private:
+    std::unique_ptr<Database> owned_database_;
+    Database& database_;
+    ConnectionPool* readers_;
     sqlite3* db_;
+    std::shared_ptr<EntryCache> entry_cache_;
+    std::shared_ptr<UserCache> user_cache_;
+
+    ConnectionPool::Lease AcquireReader();
+    // 写入提交后调用：失效晚于提交，读者才不会把提交前的旧行放回缓存；
+    // 处于调用方的外层事务中时经 Database::AfterCommit 延后到该事务提交
+    void InvalidateCachedEntry(int entry_id);
+    void InvalidateCachedCodebook(int codebook_id);
 
     bool BeginTransaction();
     bool CommitTransaction();
     bool RollbackTransaction();
     bool CheckCodebookExists(int codebook_id);
+    // 须持有写锁：轮换进行中时抛出 logic_error，否则标记密码本参与同步
+    void JoinSync(int codebook_id);
     bool ValidateCodebookName(const std::string& name);
+    void ValidateEntryFields(const std::string& address,
+                             size_t public_key_size,
+                             size_t encrypted_password_size);
 };
\ No newline at end of file
@@ -0,0 +1,88 @@
+#include "PasswordPolicy.h"
+#include <array>
+
+namespace {
+
+struct ByteInfo {
+    std::array<unsigned char, 256> cls{};
+    std::array<bool, 256> ambiguous{};
+
+    constexpr ByteInfo() {
+        for (int b = 0; b < 256; ++b) {
+            char c = static_cast<char>(b);
+            cls[b] = static_cast<unsigned char>(ClassOf(c));
+            ambiguous[b] = IsAmbiguous(c);
+        }
+    }
+};
+
+constexpr ByteInfo kByteInfo;
+
+} // namespace
+
+PolicyResult PasswordPolicy::Check(std::string_view password) const {
+    PolicyResult result;
+    const unsigned permitted = allowed | required;
+    unsigned seen = 0;
+    bool ambiguous = false;
+
+    for (char c : password) {
+        unsigned char byte = static_cast<unsigned char>(c);
+        unsigned cls = kByteInfo.cls[byte];
+        seen |= cls;
+        ambiguous |= kByteInfo.ambiguous[byte];
+        result.class_counts[0] += cls == CHAR_UPPER;
+        result.class_counts[1] += cls == CHAR_LOWER;
+        result.class_counts[2] += cls == CHAR_DIGIT;
+        result.class_counts[3] += cls == CHAR_SYMBOL;
+        if (!(cls & permitted)) {
+            result.failures |= POLICY_DISALLOWED_CHAR;
+        }
+    }
+
+    if (password.size() < min_length) {
+        result.failures |= POLICY_TOO_SHORT;
+    }
+    if (password.size() > max_length) {
+        result.failures |= POLICY_TOO_LONG;
+    }
+    const PolicyFailure missing[4] = {
+        POLICY_MISSING_UPPER, POLICY_MISSING_LOWER, POLICY_MISSING_DIGIT, POLICY_MISSING_SYMBOL,
+    };
+    for (int c = 0; c < 4; ++c) {
+        if ((required & (1u << c)) && result.class_counts[c] < min_per_class) {
+            result.failures |= missing[c];
+        }
+    }
+    if (exclude_ambiguous && ambiguous) {
+        result.failures |= POLICY_AMBIGUOUS_CHAR;
+    }
+    return result;
+}
+
+std::string PolicyResult::Describe() const {
+    static const struct {
+        PolicyFailure flag;
+        const char* text;
+    } reasons[] = {
+        {POLICY_TOO_SHORT, "too short"},
+        {POLICY_TOO_LONG, "too long"},
+        {POLICY_MISSING_UPPER, "missing uppercase letter"},
+        {POLICY_MISSING_LOWER, "missing lowercase letter"},
+        {POLICY_MISSING_DIGIT, "missing digit"},
+        {POLICY_MISSING_SYMBOL, "missing symbol"},
+        {POLICY_DISALLOWED_CHAR, "contains disallowed characters"},
+        {POLICY_AMBIGUOUS_CHAR, "contains ambiguous characters"},
+    };
+
+    std::string text;
+    for (const auto& reason : reasons) {
+        if (failures & reason.flag) {
+            if (!text.empty()) {
+                text += "; ";
+            }
+            text += reason.text;
+        }
+    }
+    return text;
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+#pragma once
+#include <cstddef>
+#include <string_view>
+#include <string>
+
+// 字符类别，可按位组合
+enum CharClass : unsigned {
+    CHAR_UPPER  = 1u << 0,
+    CHAR_LOWER  = 1u << 1,
+    CHAR_DIGIT  = 1u << 2,
+    CHAR_SYMBOL = 1u << 3,
+    CHAR_OTHER  = 1u << 4,   // 其它字符（含制表符等控制字符）与非 ASCII 字节，只用于校验
+    CHAR_ALNUM  = CHAR_UPPER | CHAR_LOWER | CHAR_DIGIT,
+    CHAR_ALL    = CHAR_ALNUM | CHAR_SYMBOL,
+    CHAR_ANY    = CHAR_ALL | CHAR_OTHER
+};
+
+// 校验失败原因，可按位组合
+enum PolicyFailure : unsigned {
+    POLICY_TOO_SHORT        = 1u << 0,
+    POLICY_TOO_LONG         = 1u << 1,
+    POLICY_MISSING_UPPER    = 1u << 2,
+    POLICY_MISSING_LOWER    = 1u << 3,
+    POLICY_MISSING_DIGIT    = 1u << 4,
+    POLICY_MISSING_SYMBOL   = 1u << 5,
+    POLICY_DISALLOWED_CHAR  = 1u << 6,   // 类别不允许，或含换行符
+    POLICY_AMBIGUOUS_CHAR   = 1u << 7
+};
+
+struct PolicyResult {
+    unsigned failures = 0;
+    size_t class_counts[4] = {0, 0, 0, 0};   // 大写、小写、数字、符号
+
+    bool ok() const { return failures == 0; }
+    // 以 "; " 连接的可读原因，通过时为空
+    std::string Describe() const;
+};
+
+constexpr std::string_view kUpperChars = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+constexpr std::string_view kLowerChars = "abcdefghijklmnopqrstuvwxyz";
+constexpr std::string_view kDigitChars = "0123456789";
+constexpr std::string_view kSymbolChars = "!@#$%^&*()-_=+[]{}|;:,.<>?";
+// 容易看错的字符
+constexpr std::string_view kAmbiguousChars = "Il1|O0o";
+
+constexpr unsigned ClassOf(char c) {
+    if (c >= 'A' && c <= 'Z') return CHAR_UPPER;
+    if (c >= 'a' && c <= 'z') return CHAR_LOWER;
+    if (c >= '0' && c <= '9') return CHAR_DIGIT;
+    if (kSymbolChars.find(c) != std::string_view::npos) return CHAR_SYMBOL;
+    // 与原先正则的 . 一致：只有 \n 与 \r 不属于任何类别，制表符等其它控制字符归入 CHAR_OTHER
+    return (c == '\n' || c == '\r') ? 0u : CHAR_OTHER;
+}
+
+constexpr bool IsAmbiguous(char c) {
+    return kAmbiguousChars.find(c) != std::string_view::npos;
+}
+
+// 密码策略：生成器据此一次生成满足要求的密码，校验器用同一份策略检查输入，
+// 因此按某策略生成的密码必然通过该策略的校验。可作为模板参数在编译期展开字符表
+struct PasswordPolicy {
+    size_t min_length;
+    size_t max_length;
+    unsigned required;        // 每类至少出现 min_per_class 次
+    unsigned allowed;         // 可出现的类别（自动包含 required）
+    size_t min_per_class;
+    bool exclude_ambiguous;
+
+    // 单次扫描完成长度、类别计数与字符合法性检查
+    PolicyResult Check(std::string_view password) const;
+
+    // 字母数字，大小写与数字各至少一个
+    static constexpr PasswordPolicy Basic() {
+        return {8, 32, CHAR_ALNUM, CHAR_ALNUM, 1, false};
+    }
+    // 含特殊字符，四类各至少一个
+    static constexpr PasswordPolicy Extended() {
+        return {8, 32, CHAR_ALL, CHAR_ALL, 1, false};
+    }
+    // 便于抄写：字母数字且去掉易混淆字符
+    static constexpr PasswordPolicy Readable() {
+        return {8, 32, CHAR_ALNUM, CHAR_ALNUM, 1, true};
+    }
+    // 账户主密码：8-32 位，大小写与数字各至少一个，其它字符不限
+    static constexpr PasswordPolicy Account() {
+        return {8, 32, CHAR_ALNUM, CHAR_ANY, 1, false};
+    }
+};
\ No newline at end of file
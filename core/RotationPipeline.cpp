@@ -0,0 +1,218 @@
+#include "RotationPipeline.h"
+#include "EnvelopeMigrator.h"
+#include <sodium.h>
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+// Concurrent rewrites of the same rows are rare; give up rather than spin
+constexpr int kMaxConflictRetries = 3;
+
+} // namespace
+
+RotationPipeline::RotationPipeline(PasswordVault& vault, CryptoModule& crypto,
+                                   std::shared_ptr<HashingPool> pool, int batchSize)
+    : vault_(vault), crypto_(crypto), pool_(std::move(pool)), batchSize_(std::max(batchSize, 1)) {
+    if (!pool_) {
+        pool_ = std::make_shared<HashingPool>(crypto_pwhash_MEMLIMIT_MODERATE);
+    }
+}
+
+std::vector<PasswordVault::BlobRewrite> RotationPipeline::recrypt(std::vector<PasswordVault::EncryptedBlob>& blobs,
+                                                                  CryptoSession& oldSession,
+                                                                  CryptoSession& newSession) {
+    std::vector<PasswordVault::BlobRewrite> rewrites(blobs.size());
+    std::vector<char> needed(blobs.size(), 0);
+
+    pool_->ParallelFor(blobs.size(), [&](size_t begin, size_t end) {
+        SecureArena arena(4096);
+        for (size_t i = begin; i < end; ++i) {
+            std::vector<uint8_t>& blob = blobs[i].blob;
+            const size_t capacity = CryptoSession::maxPlaintextSize(blob.size());
+            std::span<uint8_t> out(static_cast<uint8_t*>(arena.allocate(capacity, 1)), capacity);
+
+            // Rows rewritten before a crash already open under the new key
+            size_t written = 0;
+            if (newSession.decryptRecord(blob, out, written)) {
+                arena.reset();
+                continue;
+            }
+            written = oldSession.decrypt(blob, out);
+
+            PasswordVault::BlobRewrite& rewrite = rewrites[i];
+            rewrite.entry_id = blobs[i].entry_id;
+            rewrite.new_blob.resize(CryptoSession::recordSize(written));
+            newSession.encrypt(out.first(written), rewrite.new_blob);
+            rewrite.old_blob = std::move(blob);
+            needed[i] = 1;
+            arena.reset();
+        }
+    });
+
+    std::vector<PasswordVault::BlobRewrite> result;
+    result.reserve(rewrites.size());
+    for (size_t i = 0; i < rewrites.size(); ++i) {
+        if (needed[i]) {
+            result.push_back(std::move(rewrites[i]));
+        }
+    }
+    return result;
+}
+
+// A resumed rotation must use the same passwords as the interrupted one: rows
+// behind the checkpoint would otherwise stay under a key nobody can open
+void RotationPipeline::verifyResume(int codebook_id, int lastEntryId,
+                                    CryptoSession& oldSession, CryptoSession& newSession) {
+    SecureArena check(4096);
+    std::vector<PasswordVault::EncryptedBlob> before = vault_.GetEncryptedPasswordsAfter(codebook_id, 0, 1);
+    if (!before.empty() && before.front().entry_id <= lastEntryId) {
+        const std::vector<uint8_t>& blob = before.front().blob;
+        const size_t capacity = CryptoSession::maxPlaintextSize(blob.size());
+        std::span<uint8_t> out(static_cast<uint8_t*>(check.allocate(capacity, 1)), capacity);
+        size_t written = 0;
+        if (capacity == 0 || !newSession.decryptRecord(blob, out, written)) {
+            throw std::runtime_error("New password does not match the interrupted rotation");
+        }
+        check.reset();
+    }
+
+    std::vector<PasswordVault::EncryptedBlob> after = vault_.GetEncryptedPasswordsAfter(codebook_id, lastEntryId, 1);
+    if (!after.empty()) {
+        const std::vector<uint8_t>& blob = after.front().blob;
+        const size_t capacity = CryptoSession::maxPlaintextSize(blob.size());
+        std::span<uint8_t> out(static_cast<uint8_t*>(check.allocate(capacity, 1)), capacity);
+        size_t written = 0;
+        if (capacity == 0 || !newSession.decryptRecord(blob, out, written)) {
+            oldSession.decrypt(blob, check);
+        }
+    }
+}
+
+int64_t RotationPipeline::rotate(int codebook_id, const std::string& oldPassword, const std::string& newPassword,
+                                 const ProgressCallback& progress) {
+    EnvelopeMigrator migrator(vault_, crypto_);
+    std::unique_ptr<CryptoSession> oldSession = migrator.unlock(codebook_id, oldPassword, kJobSessionTimeout);
+
+    PasswordVault::RotationCheckpoint checkpoint;
+    const bool resumed = vault_.GetRotationCheckpoint(codebook_id, checkpoint);
+    if (!resumed) {
+        // Check the old password on one row before anything is written
+        std::vector<PasswordVault::EncryptedBlob> first = vault_.GetEncryptedPasswordsAfter(codebook_id, 0, 1);
+        if (!first.empty()) {
+            SecureArena check(4096);
+            oldSession->decrypt(first.front().blob, check);
+        }
+        WriteResult begun = vault_.BeginRotation(codebook_id, crypto_.createHeader().serialize());
+        if (begun.status == WriteStatus::ConstraintFailed) {
+            throw std::logic_error("Codebook takes part in sync; its KDF header cannot be rotated");
+        }
+        if (!vault_.GetRotationCheckpoint(codebook_id, checkpoint)) {
+            throw std::runtime_error("Codebook does not exist");
+        }
+    }
+    std::unique_ptr<CryptoSession> newSession =
+        crypto_.openSession(newPassword, KdfHeader::parse(checkpoint.new_header), kJobSessionTimeout);
+    if (resumed) {
+        verifyResume(codebook_id, checkpoint.last_entry_id, *oldSession, *newSession);
+    }
+
+    const int64_t total = vault_.CountEntries(codebook_id);
+    int lastEntryId = checkpoint.last_entry_id;
+    int64_t processed = checkpoint.processed;
+    int64_t rewritten = 0;
+
+    while (true) {
+        std::vector<PasswordVault::EncryptedBlob> blobs =
+            vault_.GetEncryptedPasswordsAfter(codebook_id, lastEntryId, batchSize_);
+        if (blobs.empty()) {
+            // Rows added since the last read keep the rotation open
+            if (vault_.FinishRotation(codebook_id)) {
+                break;
+            }
+            continue;
+        }
+
+        const int batchLast = blobs.back().entry_id;
+        const int64_t batchCount = static_cast<int64_t>(blobs.size());
+        std::vector<PasswordVault::BlobRewrite> rewrites = recrypt(blobs, *oldSession, *newSession);
+        rewritten += static_cast<int64_t>(rewrites.size());
+
+        std::vector<int> conflicts =
+            vault_.ApplyRotationBatch(codebook_id, rewrites, batchLast, processed + batchCount);
+        for (int attempt = 0; !conflicts.empty(); ++attempt) {
+            if (attempt == kMaxConflictRetries) {
+                throw std::runtime_error("Entries keep changing during rotation");
+            }
+            // Re-read the rows that changed underneath and redo only those
+            std::vector<PasswordVault::EncryptedBlob> fresh;
+            for (int entry_id : conflicts) {
+                PasswordVault::EncryptedBlob blob{entry_id, {}};
+                if (vault_.GetEncryptedPassword(entry_id, blob.blob)) {
+                    fresh.push_back(std::move(blob));
+                }
+            }
+            rewrites = recrypt(fresh, *oldSession, *newSession);
+            conflicts = vault_.ApplyRotationBatch(codebook_id, rewrites, batchLast, processed + batchCount);
+        }
+
+        lastEntryId = batchLast;
+        processed += batchCount;
+        if (progress) {
+            progress(Progress{processed, std::max(total, processed)});
+        }
+    }
+    return rewritten;
+}
+
+int64_t RotationPipeline::exportEntries(int codebook_id, const std::string& masterPassword, const PageSink& sink,
+                                        const ProgressCallback& progress) {
+    EnvelopeMigrator migrator(vault_, crypto_);
+    std::unique_ptr<CryptoSession> session = migrator.unlock(codebook_id, masterPassword, kJobSessionTimeout);
+
+    const int64_t total = vault_.CountEntries(codebook_id);
+    const size_t workers = std::max<size_t>(pool_->Concurrency(), 1);
+    std::vector<std::unique_ptr<DecryptedPage>> pages;
+    for (size_t w = 0; w < workers; ++w) {
+        pages.push_back(std::make_unique<DecryptedPage>());
+    }
+
+    int64_t exported = 0;
+    std::string cursor;
+    std::string next_cursor;
+    do {
+        std::vector<PasswordVault::PasswordEntry> entries =
+            vault_.GetEntriesAfter(codebook_id, cursor, next_cursor, batchSize_);
+        if (entries.empty()) {
+            break;
+        }
+
+        // One page per worker chunk so no arena is shared between threads
+        std::vector<size_t> bounds(workers + 1);
+        for (size_t w = 0; w <= workers; ++w) {
+            bounds[w] = entries.size() * w / workers;
+        }
+        pool_->ParallelFor(workers, [&](size_t begin, size_t end) {
+            for (size_t w = begin; w < end; ++w) {
+                pages[w]->clear();
+                for (size_t i = bounds[w]; i < bounds[w + 1]; ++i) {
+                    pages[w]->add(*session, std::move(entries[i]));
+                }
+            }
+        });
+
+        for (const std::unique_ptr<DecryptedPage>& page : pages) {
+            if (!page->empty()) {
+                sink(*page);
+            }
+            page->clear();
+        }
+
+        exported += static_cast<int64_t>(entries.size());
+        if (progress) {
+            progress(Progress{exported, std::max(total, exported)});
+        }
+        cursor = next_cursor;
+    } while (!cursor.empty());
+    return exported;
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <memory>
+#include <functional>
+#include "CryptoModule.h"
+#include "PassWordVault.h"
+#include "DecryptedPage.h"
+#include "HashingPool.h"
+
+// Bulk re-encryption (master password rotation) and decrypting export of a
+// whole codebook. Each batch of rows is split across a HashingPool, whose
+// memory bound also caps concurrent Argon2 runs for legacy blobs. A rotated
+// batch is written together with its checkpoint in one transaction, so a
+// crashed rotation resumes after the last committed batch when rotate() is
+// called again with the same passwords; a resume with a different password is
+// rejected before anything is written. The new KdfHeader only replaces the
+// old one once every row is rewritten. Edits to the codebook should be held
+// off while a rotation runs: an entry re-saved under the old key behind the
+// checkpoint would stay on the old key. Codebooks that have taken part in sync
+// cannot be rotated: the new header has no way to reach the other replicas,
+// which would then reject each other's change sets for good.
+class RotationPipeline {
+public:
+    struct Progress {
+        int64_t processed;
+        int64_t total;
+    };
+    using ProgressCallback = std::function<void(const Progress&)>;
+    // Receives decrypted pages in order; a page is wiped once the sink returns
+    using PageSink = std::function<void(const DecryptedPage&)>;
+
+    // A null pool creates one sized for MODERATE Argon2 on this host
+    RotationPipeline(PasswordVault& vault, CryptoModule& crypto,
+                     std::shared_ptr<HashingPool> pool = nullptr, int batchSize = 256);
+
+    // Returns the number of entries rewritten by this call
+    int64_t rotate(int codebook_id, const std::string& oldPassword, const std::string& newPassword,
+                   const ProgressCallback& progress = {});
+    // Returns the number of entries exported
+    int64_t exportEntries(int codebook_id, const std::string& masterPassword, const PageSink& sink,
+                          const ProgressCallback& progress = {});
+
+private:
+    PasswordVault& vault_;
+    CryptoModule& crypto_;
+    std::shared_ptr<HashingPool> pool_;
+    int batchSize_;
+
+    // Throws unless the first row behind the checkpoint opens under newSession
+    // and the first row after it under oldSession (or already under newSession)
+    void verifyResume(int codebook_id, int lastEntryId, CryptoSession& oldSession, CryptoSession& newSession);
+    std::vector<PasswordVault::BlobRewrite> recrypt(std::vector<PasswordVault::EncryptedBlob>& blobs,
+                                                    CryptoSession& oldSession, CryptoSession& newSession);
+};
\ No newline at end of file
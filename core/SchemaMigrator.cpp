@@ -0,0 +1,163 @@
+#include "SchemaMigrator.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+
+// 只在存在未完成的迁移时创建
+const char* kCheckpointTableSql = R"(
+    CREATE TABLE IF NOT EXISTS SchemaMigration (
+        version INTEGER PRIMARY KEY,
+        cursor INTEGER NOT NULL,
+        total INTEGER NOT NULL
+    )
+)";
+
+} // namespace
+
+SchemaMigrator::SchemaMigrator(Database& database, vector<Migration> migrations, const Options& options)
+    : database_(database), migrations_(move(migrations)), options_(options)
+{
+    options_.batch_size = max<int64_t>(1, options_.batch_size);
+    for (size_t i = 1; i < migrations_.size(); ++i) {
+        if (migrations_[i].version <= migrations_[i - 1].version) {
+            throw invalid_argument("Migration versions must increase");
+        }
+    }
+}
+
+bool SchemaMigrator::Exec(Database& database, const char* sql) {
+    return sqlite3_exec(database.Handle(), sql, nullptr, nullptr, nullptr) == SQLITE_OK;
+}
+
+bool SchemaMigrator::HasColumn(Database& database, const char* table, const char* column) {
+    Statement stmt = database.Prepare("SELECT 1 FROM pragma_table_info(?) WHERE name = ?");
+    sqlite3_bind_text(stmt, 1, table, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, column, -1, SQLITE_STATIC);
+    return sqlite3_step(stmt) == SQLITE_ROW;
+}
+
+int SchemaMigrator::CurrentVersion() {
+    auto lock = database_.Lock();
+    Statement stmt = database_.Prepare("PRAGMA user_version");
+    return sqlite3_step(stmt) == SQLITE_ROW ? sqlite3_column_int(stmt, 0) : 0;
+}
+
+bool SchemaMigrator::Run() {
+    int current = CurrentVersion();
+    for (const Migration& migration : migrations_) {
+        if (migration.version > current && !Apply(migration)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SchemaMigrator::LoadCheckpoint(int version, int64_t& cursor, int64_t& total) {
+    Statement table = database_.Prepare(
+        "SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = 'SchemaMigration'");
+    if (sqlite3_step(table) != SQLITE_ROW) {
+        return false;
+    }
+    Statement stmt = database_.Prepare("SELECT cursor, total FROM SchemaMigration WHERE version = ?");
+    sqlite3_bind_int(stmt, 1, version);
+    if (sqlite3_step(stmt) != SQLITE_ROW) {
+        return false;
+    }
+    cursor = sqlite3_column_int64(stmt, 0);
+    total = sqlite3_column_int64(stmt, 1);
+    return true;
+}
+
+bool SchemaMigrator::SaveCheckpoint(int version, int64_t cursor, int64_t total) {
+    Statement stmt = database_.Prepare(R"(
+        INSERT INTO SchemaMigration (version, cursor, total) VALUES (?, ?, ?)
+        ON CONFLICT(version) DO UPDATE SET cursor = excluded.cursor
+    )");
+    sqlite3_bind_int(stmt, 1, version);
+    sqlite3_bind_int64(stmt, 2, cursor);
+    sqlite3_bind_int64(stmt, 3, total);
+    return sqlite3_step(stmt) == SQLITE_DONE;
+}
+
+// PRAGMA 不能绑定参数，版本号是整数，直接拼接
+bool SchemaMigrator::SetVersion(int version) {
+    string sql = "PRAGMA user_version = " + to_string(version);
+    return Exec(database_, sql.c_str());
+}
+
+bool SchemaMigrator::Finish(int version) {
+    Statement stmt = database_.Prepare("DELETE FROM SchemaMigration WHERE version = ?");
+    sqlite3_bind_int(stmt, 1, version);
+    return sqlite3_step(stmt) == SQLITE_DONE && SetVersion(version);
+}
+
+// body 返回 false 或抛出异常时回滚
+bool SchemaMigrator::Transact(const function<bool()>& body) {
+    if (!database_.BeginTransaction()) {
+        return false;
+    }
+    try {
+        if (body() && database_.CommitTransaction()) {
+            return true;
+        }
+    } catch (...) {
+        database_.RollbackTransaction();
+        throw;
+    }
+    database_.RollbackTransaction();
+    return false;
+}
+
+bool SchemaMigrator::Apply(const Migration& migration) {
+    int64_t cursor = 0;
+    int64_t total = 0;
+
+    {
+        auto lock = database_.Lock();
+        bool started = LoadCheckpoint(migration.version, cursor, total) || Transact([&] {
+            total = migration.prepare(database_);
+            if (total < 0) {
+                return false;
+            }
+            // 需要回填时 prepare 与断点一同提交，否则直接推进版本
+            if (total == 0) {
+                return SetVersion(migration.version);
+            }
+            return Exec(database_, kCheckpointTableSql) && SaveCheckpoint(migration.version, 0, total);
+        });
+        if (!started) {
+            return false;
+        }
+    }
+
+    if (options_.progress) {
+        options_.progress(Progress{migration.version, migration.name, cursor, total});
+    }
+    if (total == 0) {
+        return true;
+    }
+
+    while (cursor < total) {
+        int64_t upto = min(total, cursor + options_.batch_size);
+        {
+            // 每批单独持锁，批与批之间其它写入可以执行
+            auto lock = database_.Lock();
+            bool committed = Transact([&] {
+                return migration.backfill(database_, cursor, upto) && SaveCheckpoint(migration.version, upto, total);
+            });
+            if (!committed) {
+                return false;
+            }
+        }
+        cursor = upto;
+        if (options_.progress) {
+            options_.progress(Progress{migration.version, migration.name, cursor, total});
+        }
+    }
+
+    auto lock = database_.Lock();
+    return Transact([&] { return Finish(migration.version); });
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "Database.h"
+
+// 以 PRAGMA user_version 记录的版本化结构迁移。
+// 每个迁移分两段：prepare 在单个事务中执行结构变更并返回需要回填的键上界；
+// backfill 按键区间 (after, upto] 分批回填，每批一个短事务，批与批之间释放写锁，
+// 其它写入可以插队。回填进度记在 SchemaMigration 表中，中断后下次打开从断点继续，
+// 不会重做 prepare。全部回填完成后才在同一事务中删除进度并推进 user_version。
+// 数据库已是最新版本时 Run 只读取一次 user_version
+class SchemaMigrator {
+public:
+    struct Migration {
+        int version;        // 完成后写入 user_version，须严格递增
+        const char* name;
+        // 返回回填键上界（通常为 MAX(entry_id)），0 表示无需回填，负数表示失败
+        std::function<int64_t(Database& database)> prepare;
+        // 回填 (after, upto] 内的行；prepare 返回 0 时可为空
+        std::function<bool(Database& database, int64_t after, int64_t upto)> backfill;
+    };
+
+    struct Progress {
+        int version;
+        const char* name;
+        int64_t done;       // 已回填到的键
+        int64_t total;      // 回填键上界，无需回填时为 0
+    };
+    using ProgressCallback = std::function<void(const Progress&)>;
+
+    struct Options {
+        int64_t batch_size = 5000;   // 每批回填的键区间长度
+        ProgressCallback progress;
+    };
+
+    SchemaMigrator(Database& database, std::vector<Migration> migrations, const Options& options);
+    SchemaMigrator(Database& database, std::vector<Migration> migrations)
+        : SchemaMigrator(database, std::move(migrations), Options()) {}
+
+    // 依次执行版本高于当前 user_version 的迁移；失败时已完成的迁移与已提交的批次保留
+    bool Run();
+
+    int CurrentVersion();
+    int TargetVersion() const { return migrations_.empty() ? 0 : migrations_.back().version; }
+
+    // 供迁移步骤使用：执行多语句脚本；检查列是否存在
+    static bool Exec(Database& database, const char* sql);
+    static bool HasColumn(Database& database, const char* table, const char* column);
+
+private:
+    Database& database_;
+    std::vector<Migration> migrations_;
+    Options options_;
+
+    bool Apply(const Migration& migration);
+    bool Transact(const std::function<bool()>& body);
+    bool LoadCheckpoint(int version, int64_t& cursor, int64_t& total);
+    bool SaveCheckpoint(int version, int64_t cursor, int64_t total);
+    bool SetVersion(int version);
+    bool Finish(int version);
+};
\ No newline at end of file
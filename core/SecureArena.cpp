@@ -0,0 +1,108 @@
+#include "SecureArena.h"
+#include <sodium.h>
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+// sodium_malloc places the region against the trailing guard page, so the
+// returned pointer is only as aligned as the requested size
+constexpr size_t kBlockGranularity = 64;
+
+size_t roundUp(size_t value, size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+} // namespace
+
+SecureArena::SecureArena(size_t blockSize)
+    : blockSize_(roundUp(std::max<size_t>(blockSize, kBlockGranularity), kBlockGranularity)) {
+    if (sodium_init() < 0) {
+        throw std::runtime_error("Libsodium initialization failed");
+    }
+}
+
+SecureArena::~SecureArena() {
+    release();
+}
+
+SecureArena::Block& SecureArena::addBlock(size_t minSize) {
+    size_t size = std::max(blockSize_, roundUp(minSize, kBlockGranularity));
+    unsigned char* data = static_cast<unsigned char*>(sodium_malloc(size));
+    if (!data) {
+        throw std::bad_alloc();
+    }
+    blocks_.push_back(Block{data, size, 0});
+    return blocks_.back();
+}
+
+void* SecureArena::allocate(size_t size, size_t alignment) {
+    if (size == 0) {
+        size = 1;
+    }
+    if (!blocks_.empty()) {
+        Block& block = blocks_.back();
+        uintptr_t base = reinterpret_cast<uintptr_t>(block.data);
+        size_t offset = roundUp(base + block.used, alignment) - base;
+        if (offset <= block.size && size <= block.size - offset) {
+            block.used = offset + size;
+            return block.data + offset;
+        }
+    }
+
+    Block& block = addBlock(size + alignment);
+    uintptr_t base = reinterpret_cast<uintptr_t>(block.data);
+    size_t offset = roundUp(base, alignment) - base;
+    block.used = offset + size;
+    return block.data + offset;
+}
+
+void SecureArena::deallocate(void* p, size_t size) noexcept {
+    if (!p) {
+        return;
+    }
+    sodium_memzero(p, size);
+    if (!blocks_.empty()) {
+        Block& block = blocks_.back();
+        unsigned char* bytes = static_cast<unsigned char*>(p);
+        if (bytes >= block.data && bytes + size == block.data + block.used) {
+            block.used = static_cast<size_t>(bytes - block.data);
+        }
+    }
+}
+
+void SecureArena::reset() noexcept {
+    if (blocks_.empty()) {
+        return;
+    }
+    sodium_memzero(blocks_.front().data, blocks_.front().used);
+    blocks_.front().used = 0;
+    // sodium_free zeroes the region before releasing it
+    for (size_t i = 1; i < blocks_.size(); ++i) {
+        sodium_free(blocks_[i].data);
+    }
+    blocks_.resize(1);
+}
+
+void SecureArena::release() noexcept {
+    for (Block& block : blocks_) {
+        sodium_free(block.data);
+    }
+    blocks_.clear();
+}
+
+size_t SecureArena::bytesUsed() const {
+    size_t used = 0;
+    for (const Block& block : blocks_) {
+        used += block.used;
+    }
+    return used;
+}
+
+size_t SecureArena::bytesReserved() const {
+    size_t reserved = 0;
+    for (const Block& block : blocks_) {
+        reserved += block.size;
+    }
+    return reserved;
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <new>
+
+// Bump allocator over sodium_malloc'd blocks. Every block is mlock'd and
+// bracketed by guard pages; objects inside one block are not guarded from each
+// other. Freed regions are wiped immediately, and reset() wipes everything
+// handed out in one pass, so bulk decrypts pay one sodium_malloc per block
+// instead of one per secret. Not thread-safe: use one arena per thread/page.
+class SecureArena {
+public:
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+    explicit SecureArena(size_t blockSize = DEFAULT_BLOCK_SIZE);
+    ~SecureArena();
+
+    SecureArena(const SecureArena&) = delete;
+    SecureArena& operator=(const SecureArena&) = delete;
+
+    // Throws std::bad_alloc when sodium_malloc fails
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+    // Wipes the region; the space is reclaimed only if it was the latest allocation
+    void deallocate(void* p, size_t size) noexcept;
+
+    // Wipes all allocations and keeps the first block for reuse
+    void reset() noexcept;
+    // Wipes and returns every block to the system
+    void release() noexcept;
+
+    size_t bytesUsed() const;
+    size_t bytesReserved() const;
+
+private:
+    struct Block {
+        unsigned char* data;
+        size_t size;
+        size_t used;
+    };
+
+    std::vector<Block> blocks_;
+    size_t blockSize_;
+
+    Block& addBlock(size_t minSize);
+};
+
+// Standard allocator adapter so containers can live inside a SecureArena
+template <typename T>
+class SecureAllocator {
+public:
+    using value_type = T;
+
+    explicit SecureAllocator(SecureArena& arena) noexcept : arena_(&arena) {}
+    template <typename U>
+    SecureAllocator(const SecureAllocator<U>& other) noexcept : arena_(other.arena()) {}
+
+    T* allocate(size_t n) {
+        if (n > static_cast<size_t>(-1) / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T* p, size_t n) noexcept {
+        arena_->deallocate(p, n * sizeof(T));
+    }
+
+    SecureArena* arena() const noexcept { return arena_; }
+
+    template <typename U>
+    bool operator==(const SecureAllocator<U>& other) const noexcept { return arena_ == other.arena(); }
+
+private:
+    SecureArena* arena_;
+};
+
+using SecureBytes = std::vector<uint8_t, SecureAllocator<uint8_t>>;
+using SecureString = std::basic_string<char, std::char_traits<char>, SecureAllocator<char>>;
\ No newline at end of file
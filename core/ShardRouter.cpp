@@ -0,0 +1,87 @@
+#include "ShardRouter.h"
+#include "UserAuth.h"
+#include "VaultSchema.h"
+#include <filesystem>
+#include <stdexcept>
+
+using namespace std;
+
+ShardRouter::ShardRouter(UserAuth& directory, const Options& options)
+    : directory_(directory), options_(options) {
+    if (options_.shard_count == 0) {
+        throw invalid_argument("Shard count must be positive");
+    }
+    filesystem::create_directories(options_.directory);
+
+    shards_.reserve(options_.shard_count);
+    for (size_t i = 0; i < options_.shard_count; ++i) {
+        shards_.push_back(make_unique<ShardState>());
+    }
+    directory_.SetShardRouter(this);
+}
+
+ShardRouter::~ShardRouter() {
+    directory_.SetShardRouter(nullptr);
+}
+
+uint64_t ShardRouter::Hash(string_view username) {
+    // FNV-1a：短键上分布足够均匀，且与平台、标准库实现无关，分片位置不会随编译器改变
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : username) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+size_t ShardRouter::ShardOf(const string& username) const {
+    return static_cast<size_t>(Hash(username) % shards_.size());
+}
+
+string ShardRouter::ShardPath(size_t shard) const {
+    string name = options_.prefix + "-" + to_string(shards_.size()) + "-" + to_string(shard) + ".db";
+    return (filesystem::path(options_.directory) / name).string();
+}
+
+PasswordVault& ShardRouter::VaultFor(const string& username) {
+    return Shard(ShardOf(username));
+}
+
+PasswordVault& ShardRouter::Shard(size_t shard) {
+    ShardState& state = *shards_.at(shard);
+    // 打开失败时 once_flag 不置位，下次访问重试
+    call_once(state.opened, [&] { Open(state, shard); });
+    return *state.vault;
+}
+
+WriteResult ShardRouter::CreateCodebook(const string& username, const string& name) {
+    if (!directory_.UserExists(username)) {
+        return {WriteStatus::NotFound};
+    }
+    return VaultFor(username).CreateCodebook(username, name);
+}
+
+void ShardRouter::Open(ShardState& shard, size_t index) {
+    string path = ShardPath(index);
+    auto database = make_unique<Database>(path, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE);
+    database->Configure(options_.profile);
+    SchemaMigrator::ProgressCallback progress;
+    if (options_.migration_progress) {
+        progress = [this, index](const SchemaMigrator::Progress& p) { options_.migration_progress(index, p); };
+    }
+    if (!CreateVaultSchema(*database, false, progress)) {
+        throw runtime_error("Table creation failed: " + path);
+    }
+
+    unique_ptr<ConnectionPool> readers;
+    if (options_.profile.read_pool_size > 0) {
+        readers = make_unique<ConnectionPool>(path, options_.profile, options_.profile.read_pool_size);
+    }
+    auto vault = make_unique<PasswordVault>(*database, readers.get());
+    // 与中心目录共用用户缓存：分片中新建、删除密码本后登录时的列表随之更新
+    vault->SetUserCache(directory_.GetUserCache());
+
+    shard.database = move(database);
+    shard.readers = move(readers);
+    shard.vault = move(vault);
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Database.h"
+#include "ConnectionPool.h"
+#include "PassWordVault.h"
+#include "SchemaMigrator.h"
+
+class UserAuth;
+
+// 按用户名分片的密码本存储。用户目录（User 表）仍在 UserAuth 的中心库，
+// 每个用户的密码本与条目放在 FNV-1a(username) % shard_count 对应的独立库文件中。
+// 每个分片有自己的写连接与写锁、读连接池和 WAL：不同分片的租户写入互不排队，
+// 单个文件和检查点的规模只随本分片的用户增长。
+// codebook_id 只在分片内唯一，须通过 VaultFor(username) 取得的 PasswordVault 使用；
+// 共享 EntryCache 时同样按分片各用一份。
+// 分片数写进文件名，修改 shard_count 会打开一组新文件而不是把用户路由到错误的旧文件。
+// 中心库里已有的密码本不会自动搬迁，可用 VaultArchive 导出后导入分片
+class ShardRouter {
+public:
+    struct Options {
+        std::string directory = ".";
+        std::string prefix = "vault";   // 文件名 <prefix>-<shard_count>-<index>.db
+        size_t shard_count = 16;
+        StorageProfile profile;         // 每个分片各自生效，读连接总数为 read_pool_size * 已打开分片数
+        // 分片在首次打开时升级旧结构，回填进度连同分片序号报告；在打开分片的线程上调用
+        std::function<void(size_t shard, const SchemaMigrator::Progress& progress)> migration_progress;
+    };
+
+    // 构造后 directory.Login 从分片读取密码本列表；directory 必须比 ShardRouter 活得久
+    ShardRouter(UserAuth& directory, const Options& options);
+    ~ShardRouter();
+
+    ShardRouter(const ShardRouter&) = delete;
+    ShardRouter& operator=(const ShardRouter&) = delete;
+
+    static uint64_t Hash(std::string_view username);
+    size_t ShardOf(const std::string& username) const;
+    std::string ShardPath(size_t shard) const;
+    size_t ShardCount() const { return shards_.size(); }
+
+    // 分片在首次访问时打开并建表；返回的引用在 ShardRouter 生命周期内有效
+    PasswordVault& VaultFor(const std::string& username);
+    PasswordVault& Shard(size_t shard);
+
+    // 分片库没有指向 User 的外键，新建前先向中心目录确认用户存在，不存在时返回 NotFound
+    WriteResult CreateCodebook(const std::string& username, const std::string& name);
+
+private:
+    struct ShardState {
+        std::once_flag opened;
+        std::unique_ptr<Database> database;
+        std::unique_ptr<ConnectionPool> readers;
+        std::unique_ptr<PasswordVault> vault;
+    };
+
+    UserAuth& directory_;
+    Options options_;
+    std::vector<std::unique_ptr<ShardState>> shards_;
+
+    void Open(ShardState& shard, size_t index);
+};
\ No newline at end of file
@@ -1,169 +1,272 @@
 #include "UserAuth.h"
+#include "VaultSchema.h"
+#include "ShardRouter.h"
 #include <sodium.h>
-#include <regex>
 #include <algorithm>
 
-UserAuth::UserAuth(const std::string& db_path) : db_(nullptr) {
+UserAuth::UserAuth(const std::string& db_path, const StorageProfile& profile, const KdfPolicy& policy,
+                   const SchemaMigrator::ProgressCallback& migration_progress)
+    : user_cache_(std::make_shared<UserCache>()), policy_(policy), db_(nullptr) {
     if (sodium_init() < 0) {
         throw std::runtime_error("Libsodium initialization failed");
     }
     
-    if (sqlite3_open_v2(db_path.c_str(), &db_, 
-                       SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE,
-                       nullptr) != SQLITE_OK) {
-        throw std::runtime_error("Database open failed: " + std::string(sqlite3_errmsg(db_)));
-    }
+    database_ = std::make_unique<Database>(db_path,
+                                           SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE);
+    db_ = database_->Handle();
+    database_->Configure(profile);
     
-    if (!CreateTables()) {
-        sqlite3_close_v2(db_);
+    if (!CreateTables(migration_progress)) {
         throw std::runtime_error("Table creation failed");
     }
+
+    // 只读连接看不到内存库，此时所有读都走写连接
+    bool in_memory = db_path.empty() || db_path == ":memory:";
+    if (profile.read_pool_size > 0 && !in_memory) {
+        read_pool_ = std::make_unique<ConnectionPool>(db_path, profile, profile.read_pool_size);
+    }
 }
 
-UserAuth::~UserAuth() {
-    if (db_) {
-        sqlite3_close_v2(db_);
+ConnectionPool::Lease UserAuth::AcquireReader() {
+    if (read_pool_) {
+        return read_pool_->Acquire();
     }
+    return ConnectionPool::Lease(nullptr, database_.get());
 }
 
-bool UserAuth::CreateTables() {
-    const char* sql = R"(
-        CREATE TABLE IF NOT EXISTS User (
-            username TEXT PRIMARY KEY,
-            password_hash TEXT NOT NULL
-        );
-        
-        CREATE TABLE IF NOT EXISTS Codebook (
-            codebook_id INTEGER PRIMARY KEY AUTOINCREMENT,
-            username TEXT NOT NULL,
-            codebook_name TEXT NOT NULL,
-            created_time DATETIME DEFAULT CURRENT_TIMESTAMP,
-            FOREIGN KEY(username) REFERENCES User(username) ON DELETE CASCADE,
-            UNIQUE(username, codebook_name)
-        );
-        
-        CREATE TABLE IF NOT EXISTS PasswordEntry (
-            entry_id INTEGER PRIMARY KEY AUTOINCREMENT,
-            codebook_id INTEGER NOT NULL,
-            created_time DATETIME DEFAULT CURRENT_TIMESTAMP,
-            address TEXT NOT NULL CHECK(length(address) <= 253),
-            public_key BLOB NOT NULL CHECK(length(public_key) <= 4096),
-            encrypted_password BLOB NOT NULL CHECK(length(encrypted_password) <= 512),
-            notes TEXT CHECK(length(notes) <= 1024),
-            FOREIGN KEY(codebook_id) REFERENCES Codebook(codebook_id) ON DELETE CASCADE
-        );
-        
-        CREATE INDEX IF NOT EXISTS idx_codebook ON PasswordEntry(codebook_id);
-        PRAGMA foreign_keys = ON;
-    )";
+// 缓存语句由 Database 析构时统一 finalize 并关闭连接
+UserAuth::~UserAuth() = default;
 
-    char* errMsg = nullptr;
-    int rc = sqlite3_exec(db_, sql, nullptr, nullptr, &errMsg);
-    if (rc != SQLITE_OK) {
-        std::string error = errMsg ? errMsg : "Unknown error";
-        sqlite3_free(errMsg);
-        return false;
-    }
-    return true;
+bool UserAuth::CreateTables(const SchemaMigrator::ProgressCallback& progress) {
+    return CreateVaultSchema(*database_, true, progress);
 }
 
-bool UserAuth::Register(const std::string& username, const std::string& password) {
+WriteResult UserAuth::Register(const std::string& username, const std::string& password) {
+    Metrics::ScopedTimer timer(Metrics::Op::AuthRegister);
     if (username.empty() || username.length() > 50) {
         throw std::invalid_argument("Username must be 1-50 characters");
     }
     
-    if (!ValidatePassword(password)) {
-        throw std::invalid_argument("Password does not meet complexity requirements");
+    PolicyResult check = CheckPassword(password);
+    if (!check.ok()) {
+        throw std::invalid_argument("Password does not meet complexity requirements: " + check.Describe());
     }
 
+    // 只读预检：已占用的用户名不必再付一次 Argon2 的代价。
+    // 它不参与判定，并发注册由 ON CONFLICT 在插入时裁决
     if (CheckUserExists(username)) {
-        return false;
+        return {WriteStatus::AlreadyExists};
     }
 
+    // Argon2 在锁外运行，只有写库时占用写连接
     std::string hash = GenerateHash(password);
     
-    sqlite3_stmt* stmt;
-    const char* sql = "INSERT INTO User (username, password_hash) VALUES (?, ?)";
+    const char* sql = R"(
+        INSERT INTO User (username, password_hash) VALUES (?, ?)
+        ON CONFLICT(username) DO NOTHING
+    )";
     
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        throw std::runtime_error("Prepare statement failed: " + std::string(sqlite3_errmsg(db_)));
-    }
+    auto lock = database_->Lock();
+    Statement stmt = database_->Prepare(sql);
 
     sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_STATIC);
     sqlite3_bind_text(stmt, 2, hash.c_str(), -1, SQLITE_STATIC);
 
-    bool success = sqlite3_step(stmt) == SQLITE_DONE;
-    sqlite3_finalize(stmt);
-    return success;
+    int rc = sqlite3_step(stmt);
+    if (rc != SQLITE_DONE) {
+        return {database_->StatusOf(rc)};
+    }
+    if (sqlite3_changes(db_) == 0) {
+        return {WriteStatus::AlreadyExists};
+    }
+    user_cache_->AddUser(username, hash);
+    return {WriteStatus::Ok};
 }
 
 bool UserAuth::Login(const std::string& username, const std::string& password, 
                    std::vector<CodebookInfo>& codebooks) {
+    Metrics::ScopedTimer timer(Metrics::Op::AuthLogin);
     std::string stored_hash;
     if (!GetUserHash(username, stored_hash)) {
         return false;
     }
     
-    if (crypto_pwhash_str_verify(stored_hash.c_str(),
-                                password.c_str(),
-                                password.length()) != 0) {
+    if (!VerifyPassword(stored_hash, password)) {
         return false;
     }
     
+    RehashIfNeeded(username, password, stored_hash);
     return GetUserCodebooks(username, codebooks);
 }
 
+std::future<WriteResult> UserAuth::RegisterAsync(const std::string& username, const std::string& password) {
+    return GetHashingPool()->Submit([this, username, password] {
+        return Register(username, password);
+    });
+}
+
+std::future<UserAuth::LoginResult> UserAuth::LoginAsync(const std::string& username,
+                                                        const std::string& password) {
+    return GetHashingPool()->Submit([this, username, password] {
+        LoginResult result;
+        result.success = Login(username, password, result.codebooks);
+        return result;
+    });
+}
+
+void UserAuth::RegisterAsync(const std::string& username, const std::string& password,
+                             std::function<void(WriteResult, std::exception_ptr)> callback) {
+    // 队列已满时 TrySubmit 不执行任务，就地以 HashingQueueFull 通知调用方
+    bool accepted = GetHashingPool()->TrySubmit([this, username, password, callback] {
+        WriteResult result;
+        std::exception_ptr error;
+        try {
+            result = Register(username, password);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        callback(result, error);
+    });
+    if (!accepted) {
+        callback(WriteResult(), std::make_exception_ptr(HashingQueueFull()));
+    }
+}
+
+void UserAuth::LoginAsync(const std::string& username, const std::string& password,
+                          std::function<void(LoginResult, std::exception_ptr)> callback) {
+    bool accepted = GetHashingPool()->TrySubmit([this, username, password, callback] {
+        LoginResult result{false, {}};
+        std::exception_ptr error;
+        try {
+            result.success = Login(username, password, result.codebooks);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        callback(std::move(result), error);
+    });
+    if (!accepted) {
+        callback(LoginResult{false, {}}, std::make_exception_ptr(HashingQueueFull()));
+    }
+}
+
+void UserAuth::SetHashingPool(std::shared_ptr<HashingPool> pool) {
+    std::lock_guard<std::mutex> lock(hashing_pool_mutex_);
+    hashing_pool_ = std::move(pool);
+}
+
+// 返回持有的副本：并发的 SetHashingPool 替换后，旧池在最后一个提交完成前不会析构
+std::shared_ptr<HashingPool> UserAuth::GetHashingPool() {
+    std::lock_guard<std::mutex> lock(hashing_pool_mutex_);
+    if (!hashing_pool_) {
+        hashing_pool_ = std::make_shared<HashingPool>(policy_.memlimit);
+    }
+    return hashing_pool_;
+}
+
 bool UserAuth::CheckUserExists(const std::string& username) {
-    sqlite3_stmt* stmt;
+    std::string cached;
+    if (user_cache_->GetHash(username, cached)) {
+        return true;
+    }
+
     const char* sql = "SELECT 1 FROM User WHERE username = ?";
     
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        throw std::runtime_error("Prepare statement failed: " + std::string(sqlite3_errmsg(db_)));
-    }
+    ConnectionPool::Lease reader = AcquireReader();
+    Statement stmt = reader->Prepare(sql);
     
     sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_STATIC);
     bool exists = (sqlite3_step(stmt) == SQLITE_ROW);
-    sqlite3_finalize(stmt);
     return exists;
 }
 
 bool UserAuth::ValidatePassword(const std::string& password) {
-    std::regex pattern(R"((?=.*\d)(?=.*[a-z])(?=.*[A-Z]).{8,32})");
-    return std::regex_match(password, pattern);
+    return CheckPassword(password).ok();
 }
 
 std::string UserAuth::GenerateHash(const std::string& password) {
+    Metrics::ScopedTimer timer(Metrics::Op::Kdf);
+    Metrics::Add(Metrics::Counter::KdfInvocations);
     char hash[crypto_pwhash_STRBYTES];
     if (crypto_pwhash_str(hash, password.c_str(), password.length(),
-                         crypto_pwhash_OPSLIMIT_SENSITIVE,
-                         crypto_pwhash_MEMLIMIT_SENSITIVE) != 0) {
+                         policy_.opslimit,
+                         policy_.memlimit) != 0) {
         throw std::runtime_error("Password hashing failed");
     }
     return std::string(hash);
 }
 
 bool UserAuth::GetUserHash(const std::string& username, std::string& stored_hash) {
-    sqlite3_stmt* stmt;
+    if (user_cache_->GetHash(username, stored_hash)) {
+        return true;
+    }
+    uint64_t generation = user_cache_->Generation();
+
     const char* sql = "SELECT password_hash FROM User WHERE username = ?";
     
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        throw std::runtime_error("Prepare statement failed: " + std::string(sqlite3_errmsg(db_)));
-    }
+    ConnectionPool::Lease reader = AcquireReader();
+    Statement stmt = reader->Prepare(sql);
     
     sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_STATIC);
     
     if (sqlite3_step(stmt) != SQLITE_ROW) {
-        sqlite3_finalize(stmt);
         return false;
     }
     
     stored_hash = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-    sqlite3_finalize(stmt);
+    user_cache_->PutHash(username, stored_hash, generation);
     return true;
 }
 
+bool UserAuth::VerifyPassword(const std::string& stored_hash, const std::string& password) {
+    Metrics::ScopedTimer timer(Metrics::Op::Kdf);
+    Metrics::Add(Metrics::Counter::KdfInvocations);
+    return crypto_pwhash_str_verify(stored_hash.c_str(), password.c_str(), password.length()) == 0;
+}
+
+void UserAuth::RehashIfNeeded(const std::string& username, const std::string& password,
+                              const std::string& stored_hash) {
+    if (crypto_pwhash_str_needs_rehash(stored_hash.c_str(), policy_.opslimit, policy_.memlimit) == 0) {
+        return;
+    }
+
+    std::string hash = GenerateHash(password);
+
+    // 仅当库中仍是旧哈希时替换，避免覆盖并发的改密
+    const char* sql = "UPDATE User SET password_hash = ? WHERE username = ? AND password_hash = ?";
+    
+    auto lock = database_->Lock();
+    Statement stmt = database_->Prepare(sql);
+
+    sqlite3_bind_text(stmt, 1, hash.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, username.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, stored_hash.c_str(), -1, SQLITE_STATIC);
+    if (sqlite3_step(stmt) != SQLITE_DONE) {
+        return;
+    }
+    // 没有替换说明库中已是别的哈希，丢弃缓存重新加载
+    if (sqlite3_changes(db_) > 0) {
+        user_cache_->SetHash(username, hash);
+    } else {
+        user_cache_->Invalidate(username);
+    }
+}
+
 bool UserAuth::GetUserCodebooks(const std::string& username, std::vector<CodebookInfo>& codebooks) {
-    sqlite3_stmt* stmt;
+    if (shard_router_) {
+        for (PasswordVault::Codebook& codebook : shard_router_->VaultFor(username).GetUserCodebooks(username)) {
+            codebooks.push_back({codebook.id, std::move(codebook.name), std::move(codebook.created_time)});
+        }
+        return true;
+    }
+    std::vector<UserCache::Codebook> cached;
+    if (user_cache_->GetCodebooks(username, cached)) {
+        for (UserCache::Codebook& codebook : cached) {
+            codebooks.push_back({codebook.id, std::move(codebook.name), std::move(codebook.created_time)});
+        }
+        return true;
+    }
+    uint64_t generation = user_cache_->Generation();
+
     const char* sql = R"(
         SELECT codebook_id, codebook_name, created_time
         FROM Codebook
@@ -171,9 +274,8 @@ bool UserAuth::GetUserCodebooks(const std::string& username, std::vector<Codeboo
         ORDER BY created_time DESC
     )";
     
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        throw std::runtime_error("Prepare statement failed: " + std::string(sqlite3_errmsg(db_)));
-    }
+    ConnectionPool::Lease reader = AcquireReader();
+    Statement stmt = reader->Prepare(sql);
     
     sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_STATIC);
     
@@ -182,9 +284,10 @@ bool UserAuth::GetUserCodebooks(const std::string& username, std::vector<Codeboo
         info.id = sqlite3_column_int(stmt, 0);
         info.name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
         info.created_time = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+        cached.push_back({info.id, info.name, info.created_time});
         codebooks.push_back(info);
     }
     
-    sqlite3_finalize(stmt);
+    user_cache_->PutCodebooks(username, std::move(cached), generation);
     return true;
 }
\ No newline at end of file
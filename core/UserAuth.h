@@ -3,6 +3,19 @@
 #include <string>
 #include <vector>
 #include <stdexcept>
+#include <memory>
+#include "Database.h"
+#include "ConnectionPool.h"
+#include "HashingPool.h"
+#include "KdfPolicy.h"
+#include "PasswordPolicy.h"
+#include "SchemaMigrator.h"
+#include "UserCache.h"
+#include <functional>
+#include <future>
+
+class ShardRouter;
+class AsyncVault;
 
 class UserAuth {
 public:
@@ -12,22 +25,77 @@ public:
         std::string created_time;
     };
 
-    explicit UserAuth(const std::string& db_path = "UserAuth.db");
+    struct LoginResult {
+        bool success;
+        std::vector<CodebookInfo> codebooks;
+    };
+
+    // policy 决定新密码哈希的代价；旧哈希在下次登录成功时按新参数重算。
+    // 旧库升级结构时 migration_progress 在构造期间报告回填进度
+    explicit UserAuth(const std::string& db_path = "UserAuth.db",
+                      const StorageProfile& profile = StorageProfile(),
+                      const KdfPolicy& policy = KdfPolicy::Sensitive(),
+                      const SchemaMigrator::ProgressCallback& migration_progress = {});
     ~UserAuth();
 
-    bool Register(const std::string& username, const std::string& password);
+    // AlreadyExists 表示用户名已被占用；输入不合法时抛出 invalid_argument
+    WriteResult Register(const std::string& username, const std::string& password);
     bool Login(const std::string& username, const std::string& password, 
               std::vector<CodebookInfo>& codebooks);
     
+    // 异步版本：Argon2 在有界哈希池中执行，调用线程不阻塞。
+    // 回调在池线程上执行，error 非空时表示抛出了异常；队列已满时在调用线程上以 HashingQueueFull 回调。
+    // 未完成的异步调用期间 UserAuth 必须保持存活
+    std::future<WriteResult> RegisterAsync(const std::string& username, const std::string& password);
+    std::future<LoginResult> LoginAsync(const std::string& username, const std::string& password);
+    void RegisterAsync(const std::string& username, const std::string& password,
+                       std::function<void(WriteResult result, std::exception_ptr error)> callback);
+    void LoginAsync(const std::string& username, const std::string& password,
+                    std::function<void(LoginResult result, std::exception_ptr error)> callback);
+    // 多个 UserAuth 可共享同一个池以限制进程总内存；未设置时首次异步调用按默认上限创建
+    void SetHashingPool(std::shared_ptr<HashingPool> pool);
+
+    // 主密码校验策略，默认 PasswordPolicy::Account()；批量导入可直接调用 CheckPassword
+    void SetPasswordPolicy(const PasswordPolicy& policy) { password_policy_ = policy; }
+    PolicyResult CheckPassword(const std::string& password) const { return password_policy_.Check(password); }
+
     sqlite3* GetDatabaseHandle() const { return db_; }
+    Database& GetDatabase() const { return *database_; }
+    // 只读连接池，内存库或 read_pool_size 为 0 时为空
+    ConnectionPool* GetReadPool() const { return read_pool_.get(); }
+    // 登录路径的哈希与密码本列表缓存；密码本列表在交给 PasswordVault::SetUserCache 后才开始缓存
+    std::shared_ptr<UserCache> GetUserCache() const { return user_cache_; }
+
+    // 走缓存的用户存在性检查，供 ShardRouter 在分片库中新建密码本前确认
+    bool UserExists(const std::string& username) { return CheckUserExists(username); }
+    // 设置后 Login 从用户所在分片读取密码本列表；由 ShardRouter 构造时设置、析构时清除
+    void SetShardRouter(ShardRouter* router) { shard_router_ = router; }
 
 private:
+    // AsyncVault 把 Login 拆成 IO 与 KDF 两段，分别调度到不同执行器
+    friend class AsyncVault;
+
+    std::unique_ptr<Database> database_;
+    std::unique_ptr<ConnectionPool> read_pool_;
+    std::shared_ptr<UserCache> user_cache_;
+    KdfPolicy policy_;
+    PasswordPolicy password_policy_ = PasswordPolicy::Account();
+    std::shared_ptr<HashingPool> hashing_pool_;   // 最后声明，析构时先排空队列
+    std::mutex hashing_pool_mutex_;
     sqlite3* db_;
+    ShardRouter* shard_router_ = nullptr;
+
+    std::shared_ptr<HashingPool> GetHashingPool();
+
+    ConnectionPool::Lease AcquireReader();
 
-    bool CreateTables();
+    bool CreateTables(const SchemaMigrator::ProgressCallback& progress);
     bool CheckUserExists(const std::string& username);
     bool ValidatePassword(const std::string& password);
     std::string GenerateHash(const std::string& password);
     bool GetUserHash(const std::string& username, std::string& stored_hash);
+    bool VerifyPassword(const std::string& stored_hash, const std::string& password);
+    void RehashIfNeeded(const std::string& username, const std::string& password,
+                        const std::string& stored_hash);
     bool GetUserCodebooks(const std::string& username, std::vector<CodebookInfo>& codebooks);
 };
\ No newline at end of file
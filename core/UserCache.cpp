@@ -0,0 +1,149 @@
+#include "UserCache.h"
+#include <algorithm>
+
+using namespace std;
+
+UserCache::UserCache(const Options& options) : options_(options) {}
+
+uint64_t UserCache::Generation() const {
+    lock_guard<mutex> lock(mutex_);
+    return generation_;
+}
+
+UserCache::Record* UserCache::Find(const string& username, bool create) {
+    Clock::time_point now = Clock::now();
+    auto it = users_.find(username);
+    if (it != users_.end() && it->second->expires <= now) {
+        lru_.erase(it->second);
+        users_.erase(it);
+        it = users_.end();
+    }
+    if (it != users_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return &*it->second;
+    }
+    if (!create || options_.max_users == 0) {
+        return nullptr;
+    }
+
+    while (lru_.size() >= options_.max_users) {
+        users_.erase(lru_.back().username);
+        lru_.pop_back();
+    }
+    lru_.push_front(Record());
+    Record& record = lru_.front();
+    record.username = username;
+    record.expires = now + options_.ttl;
+    users_[username] = lru_.begin();
+    return &record;
+}
+
+void UserCache::EnableCodebooks() {
+    lock_guard<mutex> lock(mutex_);
+    codebooks_enabled_ = true;
+}
+
+bool UserCache::GetHash(const string& username, string& hash) {
+    lock_guard<mutex> lock(mutex_);
+    Record* record = Find(username, false);
+    if (!record || !record->has_hash) {
+        return false;
+    }
+    hash = record->hash;
+    return true;
+}
+
+void UserCache::PutHash(const string& username, const string& hash, uint64_t generation) {
+    lock_guard<mutex> lock(mutex_);
+    if (generation != generation_) {
+        return;
+    }
+    if (Record* record = Find(username, true)) {
+        record->has_hash = true;
+        record->hash = hash;
+    }
+}
+
+bool UserCache::GetCodebooks(const string& username, vector<Codebook>& codebooks) {
+    lock_guard<mutex> lock(mutex_);
+    if (!codebooks_enabled_) {
+        return false;
+    }
+    Record* record = Find(username, false);
+    if (!record || !record->has_codebooks) {
+        return false;
+    }
+    codebooks = record->codebooks;
+    return true;
+}
+
+void UserCache::PutCodebooks(const string& username, vector<Codebook> codebooks, uint64_t generation) {
+    lock_guard<mutex> lock(mutex_);
+    if (generation != generation_ || !codebooks_enabled_) {
+        return;
+    }
+    if (Record* record = Find(username, true)) {
+        record->has_codebooks = true;
+        record->codebooks = move(codebooks);
+    }
+}
+
+void UserCache::AddUser(const string& username, const string& hash) {
+    lock_guard<mutex> lock(mutex_);
+    ++generation_;
+    if (Record* record = Find(username, true)) {
+        record->has_hash = true;
+        record->hash = hash;
+        record->has_codebooks = codebooks_enabled_;
+        record->codebooks.clear();
+    }
+}
+
+void UserCache::SetHash(const string& username, const string& hash) {
+    lock_guard<mutex> lock(mutex_);
+    ++generation_;
+    if (Record* record = Find(username, false)) {
+        record->has_hash = true;
+        record->hash = hash;
+    }
+}
+
+void UserCache::AddCodebook(const string& username, const Codebook& codebook) {
+    lock_guard<mutex> lock(mutex_);
+    ++generation_;
+    Record* record = Find(username, false);
+    if (!record || !record->has_codebooks) {
+        return;
+    }
+    // 保持 created_time 降序；新建的密码本时间戳最大，通常直接落在表头
+    auto pos = find_if(record->codebooks.begin(), record->codebooks.end(),
+                       [&](const Codebook& existing) { return existing.created_time <= codebook.created_time; });
+    record->codebooks.insert(pos, codebook);
+}
+
+void UserCache::RemoveCodebook(const string& username, int codebook_id) {
+    lock_guard<mutex> lock(mutex_);
+    ++generation_;
+    Record* record = Find(username, false);
+    if (!record || !record->has_codebooks) {
+        return;
+    }
+    erase_if(record->codebooks, [&](const Codebook& existing) { return existing.id == codebook_id; });
+}
+
+void UserCache::Invalidate(const string& username) {
+    lock_guard<mutex> lock(mutex_);
+    ++generation_;
+    auto it = users_.find(username);
+    if (it != users_.end()) {
+        lru_.erase(it->second);
+        users_.erase(it);
+    }
+}
+
+void UserCache::Clear() {
+    lock_guard<mutex> lock(mutex_);
+    ++generation_;
+    lru_.clear();
+    users_.clear();
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 登录路径的按用户元数据缓存：密码哈希与密码本列表（按 created_time 降序）。
+// UserAuth 默认持有一份并缓存哈希；密码本列表由 PasswordVault 写入，只有在
+// PasswordVault::SetUserCache 接入后才开始缓存（EnableCodebooks），之后 CreateCodebook/DeleteCodebook
+// 在提交后直接修改缓存中的列表，导航时无需再查库。启用后所有写该库的 PasswordVault 都应接入，
+// 否则它们的修改要等 TTL 过期才可见。
+// 按用户 LRU 淘汰，TTL 自从库中加载起计，防止其它进程的修改长期不可见。线程安全
+class UserCache {
+public:
+    struct Codebook {
+        int id;
+        std::string name;
+        std::string created_time;
+    };
+
+    struct Options {
+        size_t max_users = 1024;
+        std::chrono::seconds ttl{60};
+    };
+
+    explicit UserCache(const Options& options);
+    UserCache() : UserCache(Options()) {}
+
+    UserCache(const UserCache&) = delete;
+    UserCache& operator=(const UserCache&) = delete;
+
+    // 读库前取得，回填时传回；期间有写入则丢弃回填（与 EntryCache 相同）
+    uint64_t Generation() const;
+
+    // 启用密码本列表缓存；未启用时 GetCodebooks 总是未命中，列表不被缓存
+    void EnableCodebooks();
+
+    bool GetHash(const std::string& username, std::string& hash);
+    void PutHash(const std::string& username, const std::string& hash, uint64_t generation);
+    bool GetCodebooks(const std::string& username, std::vector<Codebook>& codebooks);
+    void PutCodebooks(const std::string& username, std::vector<Codebook> codebooks, uint64_t generation);
+
+    // 以下在写入提交后调用
+    void AddUser(const std::string& username, const std::string& hash);   // 新用户没有密码本
+    void SetHash(const std::string& username, const std::string& hash);
+    // 只修改已缓存的列表；未缓存时下次读取会从库中加载
+    void AddCodebook(const std::string& username, const Codebook& codebook);
+    void RemoveCodebook(const std::string& username, int codebook_id);
+    void Invalidate(const std::string& username);
+    void Clear();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Record {
+        std::string username;
+        bool has_hash = false;
+        std::string hash;
+        bool has_codebooks = false;
+        std::vector<Codebook> codebooks;
+        Clock::time_point expires;
+    };
+
+    Options options_;
+    mutable std::mutex mutex_;
+    uint64_t generation_ = 0;
+    bool codebooks_enabled_ = false;
+    std::list<Record> lru_;   // 头部最近使用
+    std::unordered_map<std::string, std::list<Record>::iterator> users_;
+
+    // 取得用户记录并移到头部；过期记录被丢弃，create 为 false 时返回 nullptr
+    Record* Find(const std::string& username, bool create);
+};
\ No newline at end of file
@@ -0,0 +1,854 @@
+#include "VaultArchive.h"
+#include <sodium.h>
+#include <cctype>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr char MAGIC[4] = {'M', 'P', 'V', 'A'};
+constexpr size_t CHUNK_CHECK_SIZE = 16;
+constexpr size_t ARCHIVE_DIGEST_SIZE = 32;
+constexpr size_t MAX_TEXT_FIELD = 1024 * 1024;
+const char* const CODEBOOK_MISSING = "Codebook does not exist";
+
+void putU16(std::vector<uint8_t>& out, size_t value) {
+    if (value > 0xFFFF) {
+        throw std::runtime_error("Entry field too large for archive");
+    }
+    out.push_back(static_cast<uint8_t>(value));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+void putU32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+void putU64(uint8_t* out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+uint32_t getU32(const uint8_t* in) {
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; --i) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+uint64_t getU64(const uint8_t* in) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+template <typename Bytes>
+void putField16(std::vector<uint8_t>& out, const Bytes& field) {
+    putU16(out, field.size());
+    out.insert(out.end(), reinterpret_cast<const uint8_t*>(field.data()),
+               reinterpret_cast<const uint8_t*>(field.data()) + field.size());
+}
+
+// Running BLAKE2b over everything that passes through a Writer/Reader
+class Digest {
+public:
+    Digest() { crypto_generichash_init(&state_, nullptr, 0, ARCHIVE_DIGEST_SIZE); }
+    void update(const uint8_t* data, size_t size) { crypto_generichash_update(&state_, data, size); }
+    void final(uint8_t* out) { crypto_generichash_final(&state_, out, ARCHIVE_DIGEST_SIZE); }
+
+private:
+    crypto_generichash_state state_;
+};
+
+class Writer {
+public:
+    explicit Writer(std::ostream& out) : out_(out) {}
+
+    void write(const void* data, size_t size, bool digested = true) {
+        if (size == 0) {
+            return;
+        }
+        if (digested) {
+            digest_.update(static_cast<const uint8_t*>(data), size);
+        }
+        out_.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        if (!out_) {
+            throw std::runtime_error("Archive write failed");
+        }
+        bytes_ += size;
+    }
+    void write(const std::string& text) { write(text.data(), text.size(), false); }
+
+    Digest& digest() { return digest_; }
+    uint64_t bytes() const { return bytes_; }
+
+private:
+    std::ostream& out_;
+    Digest digest_;
+    uint64_t bytes_ = 0;
+};
+
+class Reader {
+public:
+    explicit Reader(std::istream& in) : in_(in) {}
+
+    void read(void* data, size_t size, bool digested = true) {
+        in_.read(static_cast<char*>(data), static_cast<std::streamsize>(size));
+        if (static_cast<size_t>(in_.gcount()) != size) {
+            throw std::runtime_error("Archive is truncated");
+        }
+        if (digested) {
+            digest_.update(static_cast<const uint8_t*>(data), size);
+        }
+        bytes_ += size;
+    }
+
+    Digest& digest() { return digest_; }
+    uint64_t bytes() const { return bytes_; }
+
+private:
+    std::istream& in_;
+    Digest digest_;
+    uint64_t bytes_ = 0;
+};
+
+void chunkCheck(const uint8_t* frame, const std::vector<uint8_t>& payload, uint8_t* out) {
+    crypto_generichash_state state;
+    crypto_generichash_init(&state, nullptr, 0, CHUNK_CHECK_SIZE);
+    crypto_generichash_update(&state, frame, 8);
+    crypto_generichash_update(&state, payload.data(), payload.size());
+    crypto_generichash_final(&state, out, CHUNK_CHECK_SIZE);
+}
+
+// Bounds-checked cursor over one verified chunk payload
+class PayloadCursor {
+public:
+    explicit PayloadCursor(const std::vector<uint8_t>& payload) : data_(payload.data()), left_(payload.size()) {}
+
+    std::string field(size_t lengthBytes) {
+        if (left_ < lengthBytes) {
+            throw std::runtime_error("Archive chunk is malformed");
+        }
+        size_t size = data_[0] | (lengthBytes == 2 ? static_cast<size_t>(data_[1]) << 8 : 0);
+        data_ += lengthBytes;
+        left_ -= lengthBytes;
+        if (left_ < size) {
+            throw std::runtime_error("Archive chunk is malformed");
+        }
+        std::string value(reinterpret_cast<const char*>(data_), size);
+        data_ += size;
+        left_ -= size;
+        return value;
+    }
+
+    bool done() const { return left_ == 0; }
+
+private:
+    const uint8_t* data_;
+    size_t left_;
+};
+
+std::string toBase64(const void* data, size_t size) {
+    std::string out(sodium_base64_ENCODED_LEN(size, sodium_base64_VARIANT_ORIGINAL), '\0');
+    sodium_bin2base64(out.data(), out.size(), static_cast<const unsigned char*>(data), size,
+                      sodium_base64_VARIANT_ORIGINAL);
+    out.resize(out.size() - 1);
+    return out;
+}
+
+bool fromBase64(const std::string& text, std::string& out) {
+    out.resize(text.size());
+    size_t size = 0;
+    const char* end = nullptr;
+    if (sodium_base642bin(reinterpret_cast<unsigned char*>(out.data()), out.size(), text.data(), text.size(),
+                          nullptr, &size, &end, sodium_base64_VARIANT_ORIGINAL) != 0 ||
+        end != text.data() + text.size()) {
+        return false;
+    }
+    out.resize(size);
+    return true;
+}
+
+std::string csvField(std::string_view value) {
+    if (value.find_first_of(",\"\r\n") == std::string_view::npos) {
+        return std::string(value);
+    }
+    std::string quoted = "\"";
+    for (char c : value) {
+        if (c == '"') {
+            quoted += '"';
+        }
+        quoted += c;
+    }
+    quoted += '"';
+    return quoted;
+}
+
+std::string jsonString(std::string_view value) {
+    static const char hex[] = "0123456789abcdef";
+    std::string out = "\"";
+    for (unsigned char c : value) {
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (c < 0x20) {
+                out += "\\u00";
+                out += hex[c >> 4];
+                out += hex[c & 0xF];
+            } else {
+                out += static_cast<char>(c);
+            }
+        }
+    }
+    out += '"';
+    return out;
+}
+
+// RFC 4180 records, one at a time; quoted fields may span lines
+class CsvReader {
+public:
+    explicit CsvReader(std::istream& in) : in_(in) {}
+
+    bool next(std::vector<std::string>& fields) {
+        fields.clear();
+        if (in_.peek() == std::char_traits<char>::eof()) {
+            return false;
+        }
+        std::string field;
+        bool quoted = false;
+        bool wasQuoted = false;
+        while (true) {
+            int c = in_.get();
+            if (c == std::char_traits<char>::eof()) {
+                if (quoted) {
+                    throw std::runtime_error("CSV has an unterminated quoted field");
+                }
+                fields.push_back(std::move(field));
+                return true;
+            }
+            ++bytes_;
+            if (quoted) {
+                if (c == '"') {
+                    if (in_.peek() == '"') {
+                        in_.get();
+                        ++bytes_;
+                        field += '"';
+                    } else {
+                        quoted = false;
+                    }
+                } else {
+                    field += static_cast<char>(c);
+                }
+            } else if (c == '"' && field.empty() && !wasQuoted) {
+                quoted = wasQuoted = true;
+            } else if (c == ',') {
+                fields.push_back(std::move(field));
+                field.clear();
+                wasQuoted = false;
+            } else if (c == '\n' || c == '\r') {
+                if (c == '\r' && in_.peek() == '\n') {
+                    in_.get();
+                    ++bytes_;
+                }
+                fields.push_back(std::move(field));
+                return true;
+            } else {
+                field += static_cast<char>(c);
+            }
+            if (field.size() > MAX_TEXT_FIELD) {
+                throw std::runtime_error("CSV field too large");
+            }
+        }
+    }
+
+    uint64_t bytes() const { return bytes_; }
+
+private:
+    std::istream& in_;
+    uint64_t bytes_ = 0;
+};
+
+// Minimal pull parser: enough JSON to stream the exporter's layout (and
+// skip anything else) without building a document tree
+class JsonReader {
+public:
+    explicit JsonReader(std::istream& in) : in_(in) {}
+
+    int peek() {
+        skipSpace();
+        return in_.peek();
+    }
+
+    void expect(char c) {
+        if (peek() != c) {
+            throw std::runtime_error(std::string("JSON: expected '") + c + "'");
+        }
+        take();
+    }
+
+    // Consumes c if it is next
+    bool accept(char c) {
+        if (peek() != c) {
+            return false;
+        }
+        take();
+        return true;
+    }
+
+    std::string readString() {
+        expect('"');
+        std::string out;
+        while (true) {
+            int c = take();
+            if (c == '"') {
+                return out;
+            }
+            if (c == '\\') {
+                c = take();
+                switch (c) {
+                case '"': case '\\': case '/': out += static_cast<char>(c); break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': appendCodepoint(out, readEscape()); break;
+                default: throw std::runtime_error("JSON: invalid escape");
+                }
+            } else if (c < 0x20) {
+                throw std::runtime_error("JSON: control character in string");
+            } else {
+                out += static_cast<char>(c);
+            }
+            if (out.size() > MAX_TEXT_FIELD) {
+                throw std::runtime_error("JSON string too large");
+            }
+        }
+    }
+
+    void skipValue(int depth = 0) {
+        if (depth > 64) {
+            throw std::runtime_error("JSON nested too deeply");
+        }
+        int c = peek();
+        if (c == '"') {
+            readString();
+        } else if (c == '{' || c == '[') {
+            char close = c == '{' ? '}' : ']';
+            take();
+            if (accept(close)) {
+                return;
+            }
+            do {
+                if (close == '}') {
+                    readString();
+                    expect(':');
+                }
+                skipValue(depth + 1);
+            } while (accept(','));
+            expect(close);
+        } else {
+            // Numbers and literals
+            bool any = false;
+            while (true) {
+                c = in_.peek();
+                if (c == std::char_traits<char>::eof() || !(std::isalnum(c) || c == '-' || c == '+' || c == '.')) {
+                    break;
+                }
+                take();
+                any = true;
+            }
+            if (!any) {
+                throw std::runtime_error("JSON: unexpected character");
+            }
+        }
+    }
+
+    uint64_t bytes() const { return bytes_; }
+
+private:
+    std::istream& in_;
+    uint64_t bytes_ = 0;
+
+    int take() {
+        int c = in_.get();
+        if (c == std::char_traits<char>::eof()) {
+            throw std::runtime_error("JSON is truncated");
+        }
+        ++bytes_;
+        return c;
+    }
+
+    void skipSpace() {
+        while (true) {
+            int c = in_.peek();
+            if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+                return;
+            }
+            in_.get();
+            ++bytes_;
+        }
+    }
+
+    uint32_t readHex4() {
+        uint32_t value = 0;
+        for (int i = 0; i < 4; ++i) {
+            int c = take();
+            int digit = c >= '0' && c <= '9' ? c - '0'
+                      : c >= 'a' && c <= 'f' ? c - 'a' + 10
+                      : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+            if (digit < 0) {
+                throw std::runtime_error("JSON: invalid \\u escape");
+            }
+            value = (value << 4) | static_cast<uint32_t>(digit);
+        }
+        return value;
+    }
+
+    uint32_t readEscape() {
+        uint32_t unit = readHex4();
+        if (unit >= 0xD800 && unit <= 0xDBFF) {
+            if (take() != '\\' || take() != 'u') {
+                throw std::runtime_error("JSON: unpaired surrogate");
+            }
+            uint32_t low = readHex4();
+            if (low < 0xDC00 || low > 0xDFFF) {
+                throw std::runtime_error("JSON: unpaired surrogate");
+            }
+            return 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+        }
+        if (unit >= 0xDC00 && unit <= 0xDFFF) {
+            throw std::runtime_error("JSON: unpaired surrogate");
+        }
+        return unit;
+    }
+
+    static void appendCodepoint(std::string& out, uint32_t cp) {
+        if (cp < 0x80) {
+            out += static_cast<char>(cp);
+        } else if (cp < 0x800) {
+            out += static_cast<char>(0xC0 | (cp >> 6));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            out += static_cast<char>(0xE0 | (cp >> 12));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (cp >> 18));
+            out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+};
+
+} // namespace
+
+VaultArchive::VaultArchive(PasswordVault& vault, const Options& options) : vault_(vault), options_(options) {
+    if (options_.chunkBytes == 0 || options_.chunkBytes > MAX_CHUNK_PAYLOAD / 2) {
+        throw std::invalid_argument("Chunk size out of range");
+    }
+    if (options_.batchSize == 0) {
+        throw std::invalid_argument("Batch size must be positive");
+    }
+}
+
+VaultArchive::Stats VaultArchive::exportCodebook(int codebook_id, std::ostream& out, Format format) {
+    switch (format) {
+    case Format::Csv: return exportCsv(codebook_id, out);
+    case Format::Json: return exportJson(codebook_id, out);
+    default: return exportBinary(codebook_id, out);
+    }
+}
+
+VaultArchive::Stats VaultArchive::importCodebook(int codebook_id, std::istream& in, Format format) {
+    switch (format) {
+    case Format::Csv: return importCsv(codebook_id, in);
+    case Format::Json: return importJson(codebook_id, in);
+    default: return importBinary(codebook_id, in);
+    }
+}
+
+VaultArchive::Stats VaultArchive::exportBinary(int codebook_id, std::ostream& out) {
+    Stats stats{0, 0, 0, 0};
+    Writer writer(out);
+
+    std::vector<uint8_t> header;
+    vault_.GetKdfHeader(codebook_id, header);
+    std::vector<uint8_t> fileHeader(MAGIC, MAGIC + sizeof MAGIC);
+    fileHeader.push_back(VERSION);
+    fileHeader.push_back(0);
+    putU16(fileHeader, header.size());
+    writer.write(fileHeader.data(), fileHeader.size());
+    writer.write(header.data(), header.size());
+
+    std::vector<uint8_t> payload;
+    payload.reserve(options_.chunkBytes + 8 * 1024);
+    uint32_t records = 0;
+    auto flush = [&] {
+        uint8_t frame[8];
+        putU32(frame, records);
+        putU32(frame + 4, static_cast<uint32_t>(payload.size()));
+        uint8_t check[CHUNK_CHECK_SIZE];
+        chunkCheck(frame, payload, check);
+        writer.write(frame, sizeof frame);
+        writer.write(payload.data(), payload.size());
+        writer.write(check, sizeof check);
+        ++stats.chunks;
+        payload.clear();
+        records = 0;
+    };
+
+    vault_.ForEachEntry(codebook_id, [&](const PasswordVault::EntryView& entry) {
+        putField16(payload, entry.address);
+        putField16(payload, entry.public_key);
+        putField16(payload, entry.encrypted_password);
+        putField16(payload, entry.notes);
+        if (entry.created_time.size() > 0xFF) {
+            throw std::runtime_error("Entry field too large for archive");
+        }
+        payload.push_back(static_cast<uint8_t>(entry.created_time.size()));
+        payload.insert(payload.end(), entry.created_time.begin(), entry.created_time.end());
+        ++records;
+        ++stats.entries;
+        if (payload.size() >= options_.chunkBytes) {
+            flush();
+        }
+        return true;
+    });
+    if (records > 0) {
+        flush();
+    }
+
+    uint8_t trailer[16] = {0};
+    putU64(trailer + 8, static_cast<uint64_t>(stats.entries));
+    writer.write(trailer, sizeof trailer);
+    uint8_t digest[ARCHIVE_DIGEST_SIZE];
+    writer.digest().final(digest);
+    writer.write(digest, sizeof digest, false);
+
+    stats.bytes = writer.bytes();
+    return stats;
+}
+
+VaultArchive::Stats VaultArchive::importBinary(int codebook_id, std::istream& in) {
+    Stats stats{0, 0, 0, 0};
+    Reader reader(in);
+
+    uint8_t fileHeader[8];
+    reader.read(fileHeader, sizeof fileHeader);
+    if (std::memcmp(fileHeader, MAGIC, sizeof MAGIC) != 0) {
+        throw std::runtime_error("Not a vault archive");
+    }
+    if (fileHeader[4] != VERSION) {
+        throw std::runtime_error("Unsupported vault archive version");
+    }
+    std::vector<uint8_t> header(fileHeader[6] | (static_cast<size_t>(fileHeader[7]) << 8));
+    reader.read(header.data(), header.size());
+    if (!header.empty()) {
+        adoptKdfHeader(codebook_id, header);
+    }
+
+    std::vector<uint8_t> payload;
+    std::vector<PasswordVault::EntryInput> batch;
+    int64_t seen = 0;
+    while (true) {
+        uint8_t frame[8];
+        reader.read(frame, sizeof frame);
+        uint32_t records = getU32(frame);
+        uint32_t size = getU32(frame + 4);
+
+        if (records == 0 && size == 0) {
+            uint8_t total[8];
+            reader.read(total, sizeof total);
+            uint8_t expected[ARCHIVE_DIGEST_SIZE];
+            reader.digest().final(expected);
+            uint8_t stored[ARCHIVE_DIGEST_SIZE];
+            reader.read(stored, sizeof stored, false);
+            if (sodium_memcmp(expected, stored, sizeof stored) != 0 ||
+                getU64(total) != static_cast<uint64_t>(seen)) {
+                throw std::runtime_error("Archive checksum mismatch");
+            }
+            break;
+        }
+        if (records == 0 || size > MAX_CHUNK_PAYLOAD) {
+            throw std::runtime_error("Archive chunk is malformed");
+        }
+
+        payload.resize(size);
+        reader.read(payload.data(), payload.size());
+        uint8_t stored[CHUNK_CHECK_SIZE];
+        reader.read(stored, sizeof stored);
+        uint8_t expected[CHUNK_CHECK_SIZE];
+        chunkCheck(frame, payload, expected);
+        if (sodium_memcmp(expected, stored, sizeof stored) != 0) {
+            throw std::runtime_error("Archive chunk checksum mismatch");
+        }
+
+        PayloadCursor cursor(payload);
+        batch.clear();
+        for (uint32_t i = 0; i < records; ++i) {
+            PasswordVault::EntryInput entry;
+            entry.address = cursor.field(2);
+            entry.public_key = cursor.field(2);
+            entry.encrypted_password = cursor.field(2);
+            entry.notes = cursor.field(2);
+            entry.created_time = cursor.field(1);
+            batch.push_back(std::move(entry));
+        }
+        if (!cursor.done()) {
+            throw std::runtime_error("Archive chunk is malformed");
+        }
+        seen += records;
+        flushBatch(codebook_id, batch, stats);
+    }
+
+    stats.bytes = reader.bytes();
+    return stats;
+}
+
+VaultArchive::Stats VaultArchive::exportCsv(int codebook_id, std::ostream& out) {
+    Stats stats{0, 0, 0, 0};
+    Writer writer(out);
+    writer.write(std::string("address,public_key,encrypted_password,notes,created_time\r\n"));
+
+    std::string line;
+    vault_.ForEachEntry(codebook_id, [&](const PasswordVault::EntryView& entry) {
+        line = csvField(entry.address);
+        line += ',';
+        line += toBase64(entry.public_key.data(), entry.public_key.size());
+        line += ',';
+        line += toBase64(entry.encrypted_password.data(), entry.encrypted_password.size());
+        line += ',';
+        line += csvField(entry.notes);
+        line += ',';
+        line += entry.created_time;
+        line += "\r\n";
+        writer.write(line);
+        ++stats.entries;
+        return true;
+    });
+
+    stats.chunks = 1;
+    stats.bytes = writer.bytes();
+    return stats;
+}
+
+VaultArchive::Stats VaultArchive::importCsv(int codebook_id, std::istream& in) {
+    Stats stats{0, 0, 0, 0};
+    CsvReader reader(in);
+
+    std::vector<std::string> fields;
+    if (!reader.next(fields)) {
+        return stats;
+    }
+    // Columns are matched by name so hand-edited files may reorder or add columns
+    enum { ADDRESS, PUBLIC_KEY, ENCRYPTED_PASSWORD, NOTES, CREATED_TIME, COLUMN_COUNT };
+    static const char* const names[COLUMN_COUNT] = {
+        "address", "public_key", "encrypted_password", "notes", "created_time",
+    };
+    int columns[COLUMN_COUNT] = {-1, -1, -1, -1, -1};
+    for (size_t i = 0; i < fields.size(); ++i) {
+        for (int c = 0; c < COLUMN_COUNT; ++c) {
+            if (fields[i] == names[c]) {
+                columns[c] = static_cast<int>(i);
+            }
+        }
+    }
+    if (columns[ADDRESS] < 0 || columns[ENCRYPTED_PASSWORD] < 0) {
+        throw std::runtime_error("CSV needs address and encrypted_password columns");
+    }
+
+    auto column = [&](int c) -> const std::string* {
+        int index = columns[c];
+        return index >= 0 && static_cast<size_t>(index) < fields.size() ? &fields[index] : nullptr;
+    };
+
+    std::vector<PasswordVault::EntryInput> batch;
+    while (reader.next(fields)) {
+        if (fields.size() == 1 && fields[0].empty()) {
+            continue;   // blank line
+        }
+        PasswordVault::EntryInput entry;
+        const std::string* address = column(ADDRESS);
+        const std::string* ciphertext = column(ENCRYPTED_PASSWORD);
+        bool ok = address && ciphertext && fromBase64(*ciphertext, entry.encrypted_password);
+        if (ok) {
+            entry.address = *address;
+        }
+        if (ok && column(PUBLIC_KEY)) {
+            ok = fromBase64(*column(PUBLIC_KEY), entry.public_key);
+        }
+        if (!ok) {
+            ++stats.failed;
+            continue;
+        }
+        if (column(NOTES)) {
+            entry.notes = *column(NOTES);
+        }
+        if (column(CREATED_TIME)) {
+            entry.created_time = *column(CREATED_TIME);
+        }
+        batch.push_back(std::move(entry));
+        if (batch.size() == options_.batchSize) {
+            flushBatch(codebook_id, batch, stats);
+        }
+    }
+    flushBatch(codebook_id, batch, stats);
+
+    stats.bytes = reader.bytes();
+    return stats;
+}
+
+VaultArchive::Stats VaultArchive::exportJson(int codebook_id, std::ostream& out) {
+    Stats stats{0, 0, 0, 0};
+    Writer writer(out);
+
+    std::vector<uint8_t> header;
+    vault_.GetKdfHeader(codebook_id, header);
+    writer.write("{\"format\":\"mypasswd-vault\",\"version\":" + std::to_string(VERSION) +
+                 ",\"kdf_header\":" + jsonString(toBase64(header.data(), header.size())) +
+                 ",\"entries\":[");
+
+    std::string record;
+    vault_.ForEachEntry(codebook_id, [&](const PasswordVault::EntryView& entry) {
+        record = stats.entries == 0 ? "\n" : ",\n";
+        record += "{\"address\":" + jsonString(entry.address);
+        record += ",\"public_key\":\"" + toBase64(entry.public_key.data(), entry.public_key.size());
+        record += "\",\"encrypted_password\":\"" +
+                  toBase64(entry.encrypted_password.data(), entry.encrypted_password.size());
+        record += "\",\"notes\":" + jsonString(entry.notes);
+        record += ",\"created_time\":" + jsonString(entry.created_time) + "}";
+        writer.write(record);
+        ++stats.entries;
+        return true;
+    });
+    writer.write(std::string("\n]}\n"));
+
+    stats.chunks = 1;
+    stats.bytes = writer.bytes();
+    return stats;
+}
+
+VaultArchive::Stats VaultArchive::importJson(int codebook_id, std::istream& in) {
+    Stats stats{0, 0, 0, 0};
+    JsonReader reader(in);
+    std::vector<PasswordVault::EntryInput> batch;
+
+    reader.expect('{');
+    if (!reader.accept('}')) {
+        do {
+            std::string key = reader.readString();
+            reader.expect(':');
+            if (key == "kdf_header") {
+                std::string decoded;
+                if (!fromBase64(reader.readString(), decoded)) {
+                    throw std::runtime_error("JSON kdf_header is not base64");
+                }
+                if (!decoded.empty()) {
+                    adoptKdfHeader(codebook_id, std::vector<uint8_t>(decoded.begin(), decoded.end()));
+                }
+            } else if (key == "entries") {
+                reader.expect('[');
+                if (!reader.accept(']')) {
+                    do {
+                        PasswordVault::EntryInput entry;
+                        bool ok = true;
+                        bool hasAddress = false;
+                        bool hasCiphertext = false;
+                        reader.expect('{');
+                        if (!reader.accept('}')) {
+                            do {
+                                std::string field = reader.readString();
+                                reader.expect(':');
+                                if (reader.peek() != '"') {
+                                    reader.skipValue();
+                                    continue;
+                                }
+                                std::string value = reader.readString();
+                                if (field == "address") {
+                                    entry.address = std::move(value);
+                                    hasAddress = true;
+                                } else if (field == "public_key") {
+                                    ok = ok && fromBase64(value, entry.public_key);
+                                } else if (field == "encrypted_password") {
+                                    ok = ok && fromBase64(value, entry.encrypted_password);
+                                    hasCiphertext = true;
+                                } else if (field == "notes") {
+                                    entry.notes = std::move(value);
+                                } else if (field == "created_time") {
+                                    entry.created_time = std::move(value);
+                                }
+                            } while (reader.accept(','));
+                            reader.expect('}');
+                        }
+                        if (!ok || !hasAddress || !hasCiphertext) {
+                            ++stats.failed;
+                            continue;
+                        }
+                        batch.push_back(std::move(entry));
+                        if (batch.size() == options_.batchSize) {
+                            flushBatch(codebook_id, batch, stats);
+                        }
+                    } while (reader.accept(','));
+                    reader.expect(']');
+                }
+            } else {
+                reader.skipValue();
+            }
+        } while (reader.accept(','));
+        reader.expect('}');
+    }
+    if (reader.peek() != std::char_traits<char>::eof()) {
+        throw std::runtime_error("JSON has trailing data");
+    }
+    flushBatch(codebook_id, batch, stats);
+
+    stats.bytes = reader.bytes();
+    return stats;
+}
+
+void VaultArchive::adoptKdfHeader(int codebook_id, const std::vector<uint8_t>& header) {
+    std::vector<uint8_t> existing;
+    if (vault_.GetKdfHeader(codebook_id, existing)) {
+        if (existing != header) {
+            throw std::invalid_argument("Archive KDF header does not match the target codebook");
+        }
+        return;
+    }
+    WriteResult result = vault_.SetKdfHeader(codebook_id, header);
+    if (!result) {
+        throw std::runtime_error(result.status == WriteStatus::NotFound ? CODEBOOK_MISSING
+                                                                        : "Failed to store KDF header");
+    }
+}
+
+void VaultArchive::flushBatch(int codebook_id, std::vector<PasswordVault::EntryInput>& batch, Stats& stats) {
+    if (batch.empty()) {
+        return;
+    }
+    std::vector<PasswordVault::BatchResult> results = vault_.AddEntries(codebook_id, batch);
+    for (const PasswordVault::BatchResult& result : results) {
+        if (result.success) {
+            ++stats.entries;
+        } else if (result.status == WriteStatus::NotFound) {
+            throw std::runtime_error(CODEBOOK_MISSING);
+        } else {
+            ++stats.failed;
+        }
+    }
+    ++stats.chunks;
+    batch.clear();
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "PassWordVault.h"
+
+// Streaming export/import of one codebook. Ciphertext and public keys are
+// copied byte for byte, never decrypted, so no master password is needed and
+// the target codebook must end up with the same KdfHeader to stay readable.
+//
+// Binary format (little-endian):
+//   header  "MPVA" | u8 version | u8 0 | u16 kdf_len | kdf header bytes
+//   chunk   u32 record_count | u32 payload_len | payload | 16-byte BLAKE2b of
+//           (record_count, payload_len, payload)
+//   trailer chunk with record_count = payload_len = 0, then u64 total records
+//           and a 32-byte BLAKE2b over every byte before it
+//   record  u16 len + address | u16 len + public key | u16 len + ciphertext |
+//           u16 len + notes | u8 len + created_time
+//
+// Export reads rows through one ForEachEntry scan and import writes each chunk
+// through AddEntries (one transaction per chunk), so memory stays bounded by
+// the chunk size whatever the codebook size. Every chunk is verified before it
+// is written; a corrupt or truncated archive throws after the valid chunks
+// before it have been committed. Imported entries get new ids; created_time
+// is kept, so listings keep their order except among equal timestamps.
+//
+// CSV and JSON adapters carry the same fields with binary columns in base64.
+// CSV has no room for the KdfHeader: import it into a codebook that already
+// has the right header, or use the binary/JSON forms to move a codebook.
+class VaultArchive {
+public:
+    enum class Format { Binary, Csv, Json };
+
+    struct Options {
+        size_t chunkBytes = 1024 * 1024;   // binary chunk payload target
+        size_t batchSize = 1000;           // CSV/JSON rows per AddEntries call
+    };
+
+    struct Stats {
+        int64_t entries;   // records written (export) or inserted (import)
+        int64_t failed;    // import only: rows rejected by AddEntries
+        int64_t chunks;    // binary chunks or CSV/JSON batches
+        uint64_t bytes;    // archive bytes written or read
+    };
+
+    VaultArchive(PasswordVault& vault, const Options& options);
+    explicit VaultArchive(PasswordVault& vault) : VaultArchive(vault, Options()) {}
+
+    Stats exportCodebook(int codebook_id, std::ostream& out, Format format = Format::Binary);
+    // An archive KdfHeader is adopted when the codebook has none; a different
+    // existing header throws before anything is written
+    Stats importCodebook(int codebook_id, std::istream& in, Format format = Format::Binary);
+
+    static constexpr uint8_t VERSION = 1;
+    static constexpr uint32_t MAX_CHUNK_PAYLOAD = 64 * 1024 * 1024;
+
+private:
+    PasswordVault& vault_;
+    Options options_;
+
+    Stats exportBinary(int codebook_id, std::ostream& out);
+    Stats exportCsv(int codebook_id, std::ostream& out);
+    Stats exportJson(int codebook_id, std::ostream& out);
+    Stats importBinary(int codebook_id, std::istream& in);
+    Stats importCsv(int codebook_id, std::istream& in);
+    Stats importJson(int codebook_id, std::istream& in);
+
+    void adoptKdfHeader(int codebook_id, const std::vector<uint8_t>& header);
+    void flushBatch(int codebook_id, std::vector<PasswordVault::EntryInput>& batch, Stats& stats);
+};
\ No newline at end of file
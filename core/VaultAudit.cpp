@@ -0,0 +1,156 @@
+#include "VaultAudit.h"
+#include "EnvelopeMigrator.h"
+#include <sodium.h>
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace {
+
+constexpr size_t kFingerprintSize = 16;
+
+} // namespace
+
+struct VaultAudit::Row {
+    int codebook_id;
+    int entry_id;
+    std::string address;
+    std::vector<uint8_t> blob;   // released once scanned
+    std::array<uint8_t, kFingerprintSize> fingerprint;
+    unsigned policyFailures;
+    bool breached;
+    bool undecryptable;
+};
+
+VaultAudit::VaultAudit(PasswordVault& vault, CryptoModule& crypto, std::shared_ptr<HashingPool> pool,
+                       const Options& options)
+    : vault_(vault), crypto_(crypto), pool_(std::move(pool)), options_(options) {
+    options_.batchSize = std::max(options_.batchSize, 1);
+    if (!pool_) {
+        pool_ = std::make_shared<HashingPool>(crypto_pwhash_MEMLIMIT_MODERATE);
+    }
+}
+
+void VaultAudit::scanBatch(CryptoSession& session, std::span<Row> rows, const unsigned char* key) {
+    pool_->ParallelFor(rows.size(), [&](size_t begin, size_t end) {
+        SecureArena arena(4096);
+        for (size_t i = begin; i < end; ++i) {
+            Row& row = rows[i];
+            const size_t capacity = CryptoSession::maxPlaintextSize(row.blob.size());
+            row.undecryptable = capacity == 0;
+            if (!row.undecryptable) {
+                std::span<uint8_t> out(static_cast<uint8_t*>(arena.allocate(capacity, 1)), capacity);
+                size_t written = 0;
+                try {
+                    written = session.decrypt(row.blob, out);
+                } catch (const std::exception&) {
+                    row.undecryptable = true;
+                }
+                if (!row.undecryptable) {
+                    std::string_view password(reinterpret_cast<const char*>(out.data()), written);
+                    crypto_generichash(row.fingerprint.data(), row.fingerprint.size(), out.data(), written,
+                                       key, crypto_generichash_KEYBYTES);
+                    row.policyFailures = options_.policy.Check(password).failures;
+                    row.breached = options_.breaches && options_.breaches->contains(password);
+                }
+                arena.reset();
+            }
+            std::vector<uint8_t>().swap(row.blob);
+        }
+    });
+}
+
+VaultAudit::Report VaultAudit::audit(std::span<const Target> targets, const ProgressCallback& progress) {
+    EnvelopeMigrator migrator(vault_, crypto_);
+    int64_t total = 0;
+    for (const Target& target : targets) {
+        total += vault_.CountEntries(target.codebook_id);
+    }
+
+    std::array<unsigned char, crypto_generichash_KEYBYTES> key;
+    crypto_generichash_keygen(key.data());
+
+    std::vector<Row> rows;
+    rows.reserve(static_cast<size_t>(total));
+    try {
+        for (const Target& target : targets) {
+            std::unique_ptr<CryptoSession> session =
+                migrator.unlock(target.codebook_id, target.masterPassword, kJobSessionTimeout);
+            // Check the master password on one row before scanning the rest
+            std::vector<PasswordVault::EncryptedBlob> first = vault_.GetEncryptedPasswordsAfter(target.codebook_id, 0, 1);
+            if (!first.empty()) {
+                SecureArena check(4096);
+                session->decrypt(first.front().blob, check);
+            }
+
+            size_t batchStart = rows.size();
+            auto flush = [&] {
+                scanBatch(*session, std::span<Row>(rows).subspan(batchStart), key.data());
+                batchStart = rows.size();
+                if (progress) {
+                    int64_t processed = static_cast<int64_t>(rows.size());
+                    progress(Progress{processed, std::max(total, processed)});
+                }
+            };
+            vault_.ForEachEntry(target.codebook_id, [&](const PasswordVault::EntryView& entry) {
+                rows.push_back(Row{target.codebook_id, entry.id, std::string(entry.address),
+                                   std::vector<uint8_t>(entry.encrypted_password.begin(),
+                                                        entry.encrypted_password.end()),
+                                   {}, 0, false, false});
+                if (rows.size() - batchStart == static_cast<size_t>(options_.batchSize)) {
+                    flush();
+                }
+                return true;
+            });
+            if (rows.size() > batchStart) {
+                flush();
+            }
+        }
+    } catch (...) {
+        sodium_memzero(key.data(), key.size());
+        throw;
+    }
+    sodium_memzero(key.data(), key.size());
+
+    // Equal fingerprints end up adjacent; each run longer than one is a group
+    std::vector<uint32_t> order;
+    order.reserve(rows.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+        if (!rows[i].undecryptable) {
+            order.push_back(static_cast<uint32_t>(i));
+        }
+    }
+    std::sort(order.begin(), order.end(), [&rows](uint32_t a, uint32_t b) {
+        return rows[a].fingerprint < rows[b].fingerprint;
+    });
+
+    Report report;
+    std::vector<int> groups(rows.size(), 0);
+    for (size_t i = 0; i < order.size();) {
+        size_t j = i + 1;
+        while (j < order.size() && rows[order[j]].fingerprint == rows[order[i]].fingerprint) {
+            ++j;
+        }
+        if (j - i > 1) {
+            ++report.reuseGroups;
+            for (size_t k = i; k < j; ++k) {
+                groups[order[k]] = report.reuseGroups;
+            }
+            report.reused += static_cast<int64_t>(j - i);
+        }
+        i = j;
+    }
+
+    report.scanned = static_cast<int64_t>(rows.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+        Row& row = rows[i];
+        report.weak += row.policyFailures != 0;
+        report.breached += row.breached;
+        report.undecryptable += row.undecryptable;
+        if (row.policyFailures || row.breached || row.undecryptable || groups[i]) {
+            report.findings.push_back(Finding{row.codebook_id, row.entry_id, std::move(row.address),
+                                              row.policyFailures, row.breached, row.undecryptable, groups[i]});
+        }
+    }
+    return report;
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+#include "BreachList.h"
+#include "CryptoModule.h"
+#include "HashingPool.h"
+#include "PassWordVault.h"
+#include "PasswordPolicy.h"
+
+// Reuse, strength and breach report over one or more codebooks. Rows are read
+// in batches through ForEachEntry and each batch is decrypted across a
+// HashingPool, every worker into its own SecureArena that is wiped after each
+// entry, so no plaintext reaches ordinary heap memory. Per entry the worker
+// keeps only a 16-byte BLAKE2b fingerprint keyed with a random per-audit key,
+// the PasswordPolicy failures and the breach flag. Reuse is then found by
+// sorting the fingerprints (O(n log n)) across every audited codebook; the
+// fingerprints cannot be matched against anything outside this audit.
+class VaultAudit {
+public:
+    struct Options {
+        int batchSize = 1024;
+        // Same checker UserAuth applies to master passwords by default
+        PasswordPolicy policy = PasswordPolicy::Account();
+        // Optional; not owned and must outlive audit()
+        const BreachList* breaches = nullptr;
+    };
+
+    struct Target {
+        int codebook_id;
+        std::string masterPassword;
+    };
+
+    // One flagged entry; entries without findings are not listed
+    struct Finding {
+        int codebook_id;
+        int entry_id;
+        std::string address;
+        unsigned policyFailures;   // PolicyFailure bits, 0 if the password passes
+        bool breached;
+        bool undecryptable;        // the blob did not open under the codebook key
+        int reuseGroup;            // 0 if unique, otherwise shared by every copy
+    };
+
+    struct Report {
+        int64_t scanned = 0;
+        int64_t weak = 0;
+        int64_t breached = 0;
+        int64_t reused = 0;          // entries whose password appears more than once
+        int64_t undecryptable = 0;
+        int reuseGroups = 0;
+        std::vector<Finding> findings;   // in target order, newest entries first
+    };
+
+    struct Progress {
+        int64_t processed;
+        int64_t total;
+    };
+    using ProgressCallback = std::function<void(const Progress&)>;
+
+    // A null pool creates one sized for MODERATE Argon2 on this host; the same
+    // bound then limits one-off derivations for legacy blobs
+    VaultAudit(PasswordVault& vault, CryptoModule& crypto, std::shared_ptr<HashingPool> pool,
+               const Options& options);
+    VaultAudit(PasswordVault& vault, CryptoModule& crypto, std::shared_ptr<HashingPool> pool = nullptr)
+        : VaultAudit(vault, crypto, std::move(pool), Options()) {}
+
+    // Throws if a master password is wrong; nothing is written except a
+    // KdfHeader for a codebook that has none yet (see EnvelopeMigrator)
+    Report audit(std::span<const Target> targets, const ProgressCallback& progress = {});
+
+private:
+    struct Row;
+
+    PasswordVault& vault_;
+    CryptoModule& crypto_;
+    std::shared_ptr<HashingPool> pool_;
+    Options options_;
+
+    // Decrypts and scores rows in place, keeping only the derived fields
+    void scanBatch(CryptoSession& session, std::span<Row> rows, const unsigned char* key);
+};
\ No newline at end of file
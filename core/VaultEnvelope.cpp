@@ -0,0 +1,107 @@
+#include "VaultEnvelope.h"
+#include <sodium.h>
+#include <utility>
+
+namespace {
+
+void putU64(std::vector<uint8_t>& out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+uint64_t getU64(const uint8_t* in) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i) {
+        value |= static_cast<uint64_t>(in[i]) << (8 * i);
+    }
+    return value;
+}
+
+} // namespace
+
+KdfHeader KdfHeader::createDefault() {
+    return create(crypto_pwhash_OPSLIMIT_MODERATE, crypto_pwhash_MEMLIMIT_MODERATE);
+}
+
+KdfHeader KdfHeader::create(uint64_t opslimit, uint64_t memlimit) {
+    KdfHeader header;
+    header.kdf_id = crypto_pwhash_ALG_DEFAULT;
+    header.opslimit = opslimit;
+    header.memlimit = memlimit;
+    header.salt.resize(crypto_pwhash_SALTBYTES);
+    randombytes_buf(header.salt.data(), header.salt.size());
+    return header;
+}
+
+KdfHeader KdfHeader::parse(const std::vector<uint8_t>& data) {
+    const size_t fixedSize = VaultEnvelope::PREFIX_SIZE + 1 + 8 + 8 + 1;
+    if (data.size() < fixedSize ||
+        data[0] != VaultEnvelope::MAGIC ||
+        data[1] != VaultEnvelope::VERSION) {
+        throw std::runtime_error("Invalid KDF header");
+    }
+
+    KdfHeader header;
+    header.kdf_id = data[2];
+    header.opslimit = getU64(&data[3]);
+    header.memlimit = getU64(&data[11]);
+    size_t saltLen = data[19];
+    if (saltLen != crypto_pwhash_SALTBYTES || data.size() != fixedSize + saltLen) {
+        throw std::runtime_error("Invalid KDF header salt");
+    }
+    header.salt.assign(data.begin() + fixedSize, data.end());
+    return header;
+}
+
+std::vector<uint8_t> KdfHeader::serialize() const {
+    std::vector<uint8_t> out;
+    out.reserve(VaultEnvelope::PREFIX_SIZE + 1 + 8 + 8 + 1 + salt.size());
+    out.push_back(VaultEnvelope::MAGIC);
+    out.push_back(VaultEnvelope::VERSION);
+    out.push_back(kdf_id);
+    putU64(out, opslimit);
+    putU64(out, memlimit);
+    out.push_back(static_cast<uint8_t>(salt.size()));
+    out.insert(out.end(), salt.begin(), salt.end());
+    return out;
+}
+
+size_t VaultEnvelope::recordSize(size_t plaintextSize) {
+    return PREFIX_SIZE + crypto_secretbox_NONCEBYTES + plaintextSize + crypto_secretbox_MACBYTES;
+}
+
+bool VaultEnvelope::looksLikeRecord(const uint8_t* data, size_t size) {
+    return size >= recordSize(0) && data[0] == MAGIC && data[1] == VERSION;
+}
+
+bool VaultEnvelope::decodeText(const char* text, size_t size, std::vector<uint8_t>& out) {
+    // Large enough for either encoding (base64 decodes to 3/4 of its length)
+    std::vector<uint8_t> decoded(size);
+    size_t decodedLen = 0;
+    const char* end = nullptr;
+
+    bool ok = size % 2 == 0 &&
+              sodium_hex2bin(decoded.data(), decoded.size(), text, size, nullptr, &decodedLen, &end) == 0 &&
+              end == text + size;
+    if (!ok) {
+        const int variants[] = {
+            sodium_base64_VARIANT_ORIGINAL, sodium_base64_VARIANT_ORIGINAL_NO_PADDING,
+            sodium_base64_VARIANT_URLSAFE, sodium_base64_VARIANT_URLSAFE_NO_PADDING,
+        };
+        for (int variant : variants) {
+            if (sodium_base642bin(decoded.data(), decoded.size(), text, size, nullptr,
+                                  &decodedLen, &end, variant) == 0 && end == text + size) {
+                ok = true;
+                break;
+            }
+        }
+    }
+    if (!ok || decodedLen < recordSize(0)) {
+        return false;
+    }
+
+    decoded.resize(decodedLen);
+    out = std::move(decoded);
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+
+// Binary envelope, version 1.
+//
+//   KDF header (once per codebook):
+//     magic(1) version(1) kdf_id(1) opslimit(8, LE) memlimit(8, LE) salt_len(1) salt
+//   Entry record (per PasswordEntry.encrypted_password):
+//     magic(1) version(1) nonce(crypto_secretbox_NONCEBYTES) ciphertext
+//
+// Anything else is treated as the legacy salt || nonce || ciphertext layout.
+struct KdfHeader {
+    uint8_t kdf_id;
+    uint64_t opslimit;
+    uint64_t memlimit;
+    std::vector<uint8_t> salt;
+
+    // Fresh random salt with the parameters CryptoModule has always used
+    static KdfHeader createDefault();
+    static KdfHeader create(uint64_t opslimit, uint64_t memlimit);
+    static KdfHeader parse(const std::vector<uint8_t>& data);
+    std::vector<uint8_t> serialize() const;
+};
+
+class VaultEnvelope {
+public:
+    static constexpr uint8_t MAGIC = 0xA7;
+    static constexpr uint8_t VERSION = 1;
+    static constexpr size_t PREFIX_SIZE = 2;
+
+    static size_t recordSize(size_t plaintextSize);
+    // Cheap structural check; a legacy blob may still match by chance
+    static bool looksLikeRecord(const uint8_t* data, size_t size);
+    // Decodes a hex or base64 (standard or URL-safe, padded or not) copy of a
+    // record or legacy blob, as stored by text-only callers. Returns false if
+    // the text is not fully encoded or too short to be ciphertext.
+    static bool decodeText(const char* text, size_t size, std::vector<uint8_t>& out);
+};
\ No newline at end of file
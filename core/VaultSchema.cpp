@@ -0,0 +1,260 @@
+#include "VaultSchema.h"
+#include <vector>
+
+bool CreateVaultSchema(Database& database, bool link_users, const SchemaMigrator::ProgressCallback& progress) {
+    const char* userSql = R"(
+        CREATE TABLE IF NOT EXISTS User (
+            username TEXT PRIMARY KEY,
+            password_hash TEXT NOT NULL
+        );
+    )";
+
+    // 分片库里没有 User 表，用户是否存在由中心目录判断
+    const char* codebookSql = link_users ? R"(
+        CREATE TABLE IF NOT EXISTS Codebook (
+            codebook_id INTEGER PRIMARY KEY AUTOINCREMENT,
+            username TEXT NOT NULL,
+            codebook_name TEXT NOT NULL,
+            created_time DATETIME DEFAULT CURRENT_TIMESTAMP,
+            revision INTEGER NOT NULL DEFAULT 0,
+            synced INTEGER NOT NULL DEFAULT 0,
+            FOREIGN KEY(username) REFERENCES User(username) ON DELETE CASCADE,
+            UNIQUE(username, codebook_name)
+        );
+    )" : R"(
+        CREATE TABLE IF NOT EXISTS Codebook (
+            codebook_id INTEGER PRIMARY KEY AUTOINCREMENT,
+            username TEXT NOT NULL,
+            codebook_name TEXT NOT NULL,
+            created_time DATETIME DEFAULT CURRENT_TIMESTAMP,
+            revision INTEGER NOT NULL DEFAULT 0,
+            synced INTEGER NOT NULL DEFAULT 0,
+            UNIQUE(username, codebook_name)
+        );
+    )";
+
+    const char* sql = R"(
+        CREATE TABLE IF NOT EXISTS PasswordEntry (
+            entry_id INTEGER PRIMARY KEY AUTOINCREMENT,
+            codebook_id INTEGER NOT NULL,
+            created_time DATETIME DEFAULT CURRENT_TIMESTAMP,
+            address TEXT NOT NULL CHECK(length(address) <= 253),
+            public_key BLOB NOT NULL CHECK(length(public_key) <= 4096),
+            encrypted_password BLOB NOT NULL CHECK(length(encrypted_password) <= 512),
+            notes TEXT CHECK(length(notes) <= 1024),
+            updated_time DATETIME,
+            revision INTEGER NOT NULL DEFAULT 0,
+            sync_id BLOB,
+            FOREIGN KEY(codebook_id) REFERENCES Codebook(codebook_id) ON DELETE CASCADE
+        );
+        
+        CREATE TABLE IF NOT EXISTS CodebookKdf (
+            codebook_id INTEGER PRIMARY KEY,
+            header BLOB NOT NULL CHECK(length(header) <= 64),
+            FOREIGN KEY(codebook_id) REFERENCES Codebook(codebook_id) ON DELETE CASCADE
+        );
+        
+        CREATE TABLE IF NOT EXISTS RotationCheckpoint (
+            codebook_id INTEGER PRIMARY KEY,
+            new_header BLOB NOT NULL CHECK(length(new_header) <= 64),
+            last_entry_id INTEGER NOT NULL DEFAULT 0,
+            processed INTEGER NOT NULL DEFAULT 0,
+            FOREIGN KEY(codebook_id) REFERENCES Codebook(codebook_id) ON DELETE CASCADE
+        );
+        
+        CREATE INDEX IF NOT EXISTS idx_codebook ON PasswordEntry(codebook_id);
+        -- 登录与导航按用户列出密码本：按索引顺序读出即可，无需排序也无需回表
+        CREATE INDEX IF NOT EXISTS idx_codebook_user
+            ON Codebook(username, created_time DESC, codebook_name);
+        -- 覆盖索引：分页排序之外还带上 address，摘要列表与地址过滤无需回表
+        DROP INDEX IF EXISTS idx_entry_page;
+        CREATE INDEX IF NOT EXISTS idx_entry_summary
+            ON PasswordEntry(codebook_id, created_time DESC, entry_id DESC, address);
+    )";
+
+    // 旧库补上同步列。已有条目按 entry_id 取得互不相同的 revision，
+    // 分页读取变更时同一 revision 不会被 LIMIT 截断；密码本 revision 先推进到不小于这些值
+    const char* codebookUpgradeSql = "ALTER TABLE Codebook ADD COLUMN revision INTEGER NOT NULL DEFAULT 0";
+    const char* entryUpgradeSql = R"(
+        ALTER TABLE PasswordEntry ADD COLUMN updated_time DATETIME;
+        ALTER TABLE PasswordEntry ADD COLUMN revision INTEGER NOT NULL DEFAULT 0;
+        ALTER TABLE PasswordEntry ADD COLUMN sync_id BLOB;
+        UPDATE Codebook SET revision = MAX(revision, COALESCE(
+            (SELECT MAX(entry_id) FROM PasswordEntry p WHERE p.codebook_id = Codebook.codebook_id), 0));
+    )";
+    // 回填期间被修改过的行已由更新触发器取得 sync_id，不再进入回填；
+    // 保险起见仍只填写空缺的 revision/updated_time，不覆盖触发器写入的值
+    const char* entryBackfillSql = R"(
+        UPDATE PasswordEntry SET
+            updated_time = COALESCE(updated_time, created_time),
+            revision = CASE WHEN revision = 0 THEN entry_id ELSE revision END,
+            sync_id = randomblob(16)
+        WHERE entry_id > ? AND entry_id <= ? AND sync_id IS NULL
+    )";
+
+    // 增量同步：每次新增、修改、删除条目时密码本 revision 加一并记到该行（删除记到墓碑）。
+    // sync_id 是条目在各副本间的共同标识；updated_time 精确到毫秒，供 ApplyChanges 按时间裁决。
+    // 触发器只监听内容列，自身对 revision/updated_time 的更新不会再次触发
+    const char* syncSql = R"(
+        CREATE TABLE IF NOT EXISTS EntryTombstone (
+            codebook_id INTEGER NOT NULL,
+            sync_id BLOB NOT NULL,
+            revision INTEGER NOT NULL,
+            deleted_time DATETIME NOT NULL,
+            PRIMARY KEY(codebook_id, sync_id)
+        ) WITHOUT ROWID;
+        
+        CREATE INDEX IF NOT EXISTS idx_entry_revision ON PasswordEntry(codebook_id, revision);
+        CREATE UNIQUE INDEX IF NOT EXISTS idx_entry_sync ON PasswordEntry(codebook_id, sync_id);
+        CREATE INDEX IF NOT EXISTS idx_tombstone_revision ON EntryTombstone(codebook_id, revision);
+        
+        -- 语句已带 revision 的行（AddEntries）跳过。密码本不存在时 revision 取 0，
+        -- 让插入照常以外键失败报告 NotFound
+        CREATE TRIGGER IF NOT EXISTS PasswordEntry_sync_ai AFTER INSERT ON PasswordEntry
+        WHEN new.revision = 0 BEGIN
+            UPDATE Codebook SET revision = revision + 1 WHERE codebook_id = new.codebook_id;
+            UPDATE PasswordEntry SET
+                revision = COALESCE((SELECT revision FROM Codebook WHERE codebook_id = new.codebook_id), 0),
+                updated_time = COALESCE(new.updated_time, strftime('%Y-%m-%d %H:%M:%f', 'now')),
+                sync_id = COALESCE(new.sync_id, randomblob(16))
+            WHERE entry_id = new.entry_id;
+            DELETE FROM EntryTombstone WHERE codebook_id = new.codebook_id AND sync_id = new.sync_id;
+        END;
+        
+        -- 删除密码本级联删除条目时不留墓碑
+        CREATE TRIGGER IF NOT EXISTS PasswordEntry_sync_ad AFTER DELETE ON PasswordEntry BEGIN
+            UPDATE Codebook SET revision = revision + 1 WHERE codebook_id = old.codebook_id;
+            INSERT INTO EntryTombstone (codebook_id, sync_id, revision, deleted_time)
+            SELECT old.codebook_id, old.sync_id, revision, strftime('%Y-%m-%d %H:%M:%f', 'now')
+            FROM Codebook WHERE codebook_id = old.codebook_id AND old.sync_id IS NOT NULL
+            ON CONFLICT(codebook_id, sync_id) DO UPDATE
+            SET revision = excluded.revision, deleted_time = excluded.deleted_time;
+        END;
+        
+        CREATE TRIGGER IF NOT EXISTS Codebook_sync_ad AFTER DELETE ON Codebook BEGIN
+            DELETE FROM EntryTombstone WHERE codebook_id = old.codebook_id;
+        END;
+    )";
+
+    // 语句把 revision 置为负数（ApplyChanges）表示 updated_time 来自来源副本，原样保留；
+    // 否则取当前时间。按值比较会在两边时间相同（平局裁决）时误把远端时间改成本地时间。
+    // revision = -2 表示只改存储形式、内容不变的改写（MigrateTextEncodedEntries），
+    // revision 与 updated_time 都保持原值，不作为变更同步出去。
+    // 迁移回填尚未到达的旧行在修改时同时取得 sync_id
+    const char* syncUpdateTriggerSql = R"(
+        CREATE TRIGGER IF NOT EXISTS PasswordEntry_sync_au
+        AFTER UPDATE OF address, public_key, encrypted_password, notes ON PasswordEntry BEGIN
+            UPDATE Codebook SET revision = revision + 1
+            WHERE codebook_id = new.codebook_id AND new.revision <> -2;
+            UPDATE PasswordEntry SET
+                revision = CASE WHEN new.revision = -2 THEN old.revision
+                                ELSE COALESCE((SELECT revision FROM Codebook WHERE codebook_id = new.codebook_id), 0) END,
+                updated_time = CASE WHEN new.revision < 0 THEN new.updated_time
+                                    ELSE strftime('%Y-%m-%d %H:%M:%f', 'now') END,
+                sync_id = COALESCE(new.sync_id, randomblob(16))
+            WHERE entry_id = new.entry_id;
+        END;
+    )";
+
+    // 全文索引：外部内容表，正文仍只存在 PasswordEntry 中，由触发器保持同步
+    const char* searchSql = R"(
+        CREATE VIRTUAL TABLE IF NOT EXISTS PasswordEntrySearch USING fts5(
+            address, notes,
+            content='PasswordEntry', content_rowid='entry_id',
+            tokenize='unicode61', prefix='2 3'
+        );
+        
+        CREATE TRIGGER IF NOT EXISTS PasswordEntry_search_ai AFTER INSERT ON PasswordEntry BEGIN
+            INSERT INTO PasswordEntrySearch(rowid, address, notes)
+            VALUES (new.entry_id, new.address, new.notes);
+        END;
+        
+        CREATE TRIGGER IF NOT EXISTS PasswordEntry_search_ad AFTER DELETE ON PasswordEntry BEGIN
+            INSERT INTO PasswordEntrySearch(PasswordEntrySearch, rowid, address, notes)
+            VALUES ('delete', old.entry_id, old.address, old.notes);
+        END;
+        
+        CREATE TRIGGER IF NOT EXISTS PasswordEntry_search_au
+        AFTER UPDATE OF address, notes ON PasswordEntry BEGIN
+            INSERT INTO PasswordEntrySearch(PasswordEntrySearch, rowid, address, notes)
+            VALUES ('delete', old.entry_id, old.address, old.notes);
+            INSERT INTO PasswordEntrySearch(rowid, address, notes)
+            VALUES (new.entry_id, new.address, new.notes);
+        END;
+    )";
+    const char* searchRebuildSql = "INSERT INTO PasswordEntrySearch(PasswordEntrySearch) VALUES ('rebuild')";
+
+    auto maxEntryId = [](Database& database) -> int64_t {
+        Statement stmt = database.Prepare("SELECT COALESCE(MAX(entry_id), 0) FROM PasswordEntry");
+        return sqlite3_step(stmt) == SQLITE_ROW ? sqlite3_column_int64(stmt, 0) : -1;
+    };
+    auto backfillRange = [](const char* script) {
+        return [script](Database& database, int64_t after, int64_t upto) {
+            Statement stmt = database.Prepare(script);
+            sqlite3_bind_int64(stmt, 1, after);
+            sqlite3_bind_int64(stmt, 2, upto);
+            return sqlite3_step(stmt) == SQLITE_DONE;
+        };
+    };
+
+    std::vector<SchemaMigrator::Migration> migrations;
+    migrations.push_back({1, "base tables", [=](Database& database) -> int64_t {
+        if (link_users && !SchemaMigrator::Exec(database, userSql)) {
+            return -1;
+        }
+        return SchemaMigrator::Exec(database, codebookSql) && SchemaMigrator::Exec(database, sql) ? 0 : -1;
+    }, nullptr});
+
+    // 加列只改表头，立即完成；已有条目的同步列按 entry_id 区间分批回填。
+    // 触发器在 prepare 中建立，回填期间新写入的行由触发器处理
+    migrations.push_back({2, "sync columns", [=](Database& database) -> int64_t {
+        if (!SchemaMigrator::HasColumn(database, "Codebook", "revision") &&
+            !SchemaMigrator::Exec(database, codebookUpgradeSql)) {
+            return -1;
+        }
+        int64_t total = 0;
+        if (!SchemaMigrator::HasColumn(database, "PasswordEntry", "sync_id")) {
+            total = maxEntryId(database);
+            if (total < 0 || !SchemaMigrator::Exec(database, entryUpgradeSql)) {
+                return -1;
+            }
+        }
+        return SchemaMigrator::Exec(database, syncSql) && SchemaMigrator::Exec(database, syncUpdateTriggerSql)
+            ? total : -1;
+    }, backfillRange(entryBackfillSql)});
+
+    // 旧库首次建立全文索引时，在建表与触发器的同一事务中从正文重建索引。
+    // 不能分批回填：批间的修改与删除会让触发器对尚未索引的行执行 'delete'，外部内容索引随之损坏
+    migrations.push_back({3, "full-text search", [=](Database& database) -> int64_t {
+        bool exists;
+        {
+            Statement stmt = database.Prepare(
+                "SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = 'PasswordEntrySearch'");
+            exists = sqlite3_step(stmt) == SQLITE_ROW;
+        }
+        if (!SchemaMigrator::Exec(database, searchSql)) {
+            return -1;
+        }
+        return exists || SchemaMigrator::Exec(database, searchRebuildSql) ? 0 : -1;
+    }, nullptr});
+
+    auto replaceSyncUpdateTrigger = [=](Database& database) -> int64_t {
+        return SchemaMigrator::Exec(database, "DROP TRIGGER IF EXISTS PasswordEntry_sync_au") &&
+            SchemaMigrator::Exec(database, syncUpdateTriggerSql) ? 0 : -1;
+    };
+    // 早期版本的更新触发器按 updated_time 是否变化判断来源，且不为未回填的旧行分配 sync_id，整体替换
+    migrations.push_back({4, "sync update trigger", replaceSyncUpdateTrigger, nullptr});
+    // 更新触发器支持 revision = -2 的存储改写
+    migrations.push_back({5, "storage rewrite trigger", replaceSyncUpdateTrigger, nullptr});
+
+    // 记录密码本是否参与过同步：参与后各副本共用同一 KDF 头，不再允许主密码轮换
+    migrations.push_back({6, "sync participation", [=](Database& database) -> int64_t {
+        return SchemaMigrator::HasColumn(database, "Codebook", "synced") ||
+            SchemaMigrator::Exec(database, "ALTER TABLE Codebook ADD COLUMN synced INTEGER NOT NULL DEFAULT 0")
+            ? 0 : -1;
+    }, nullptr});
+
+    SchemaMigrator::Options options;
+    options.progress = progress;
+    return SchemaMigrator(database, std::move(migrations), options).Run();
+}
\ No newline at end of file
@@ -0,0 +1,10 @@
+#pragma once
+#include "Database.h"
+#include "SchemaMigrator.h"
+
+// 密码本、条目、KDF 头、轮换检查点、同步与全文索引的表结构，经 SchemaMigrator 按版本迁移：
+// 新库与旧库走同一组迁移，大表的回填分批提交，中断后下次打开续跑；已是最新版本时只读一次 user_version。
+// UserAuth 在中心库上以 link_users = true 调用，同时建立 User 表，Codebook 以外键引用 User；
+// ShardRouter 的分片库没有 User 表，以 false 调用
+bool CreateVaultSchema(Database& database, bool link_users,
+                       const SchemaMigrator::ProgressCallback& progress = {});
\ No newline at end of file
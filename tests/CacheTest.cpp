@@ -0,0 +1,179 @@
+// 缓存与事务：外层事务中的写入只在提交后使缓存失效，回滚不留痕迹
+#include <sqlite3.h>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "EntryCache.h"
+#include "PassWordVault.h"
+#include "UserAuth.h"
+#include "Check.h"
+
+namespace {
+
+using PV = PasswordVault;
+
+const char* kPath = "mypasswd_cache_test.db";
+
+void RemoveDatabase() {
+    for (const char* suffix : {"", "-wal", "-shm"}) {
+        std::remove((std::string(kPath) + suffix).c_str());
+    }
+}
+
+// 只读连接池要求文件库：读者与外层事务处在不同连接上
+void TestEntryInvalidationAfterCommit() {
+    RemoveDatabase();
+    {
+        UserAuth auth(kPath);
+        sqlite3_exec(auth.GetDatabaseHandle(), "INSERT INTO User VALUES ('alice', 'x')", nullptr, nullptr, nullptr);
+        PV vault(auth.GetDatabase(), auth.GetReadPool());
+        vault.SetEntryCache(std::make_shared<EntryCache>());
+        int codebook = static_cast<int>(vault.CreateCodebook("alice", "main").id);
+        int entry_id = static_cast<int>(vault.AddEntry(codebook, "mail", "pk", "old").id);
+
+        PV::PasswordEntry entry;
+        CHECK(vault.GetEntryDetail(entry_id, entry));
+
+        // 事务未提交时另一线程读到旧行并放回缓存，提交后缓存仍须失效
+        CHECK(auth.GetDatabase().BeginTransaction());
+        CHECK(vault.UpdateEntry(entry_id, "mail", "pk", "new", ""));
+        std::thread([&] {
+            PV::PasswordEntry seen;
+            CHECK(vault.GetEntryDetail(entry_id, seen));
+            CHECK(seen.encrypted_password == "old");
+        }).join();
+        CHECK(auth.GetDatabase().CommitTransaction());
+        CHECK(vault.GetEntryDetail(entry_id, entry));
+        CHECK(entry.encrypted_password == "new");
+
+        CHECK(auth.GetDatabase().BeginTransaction());
+        CHECK(vault.UpdateEntry(entry_id, "mail", "pk", "rolled-back", ""));
+        CHECK(auth.GetDatabase().RollbackTransaction());
+        CHECK(vault.GetEntryDetail(entry_id, entry));
+        CHECK(entry.encrypted_password == "new");
+    }
+    RemoveDatabase();
+}
+
+// 自动提交的 DeleteCodebook：提交钩子里另一线程读到删除前的条目并放回缓存，
+// 提交后缓存仍须失效，不能留下已删除密码本的条目
+void TestDeleteCodebookRacingReader() {
+    RemoveDatabase();
+    {
+        UserAuth auth(kPath);
+        sqlite3_exec(auth.GetDatabaseHandle(), "INSERT INTO User VALUES ('alice', 'x')", nullptr, nullptr, nullptr);
+        PV vault(auth.GetDatabase(), auth.GetReadPool());
+        vault.SetEntryCache(std::make_shared<EntryCache>());
+        int codebook = static_cast<int>(vault.CreateCodebook("alice", "main").id);
+        int entry_id = static_cast<int>(vault.AddEntry(codebook, "mail", "pk", "secret").id);
+
+        struct Race {
+            PV* vault;
+            int entry_id;
+            bool seen = false;
+        } race{&vault, entry_id};
+        sqlite3_commit_hook(auth.GetDatabaseHandle(), [](void* arg) {
+            Race& race = *static_cast<Race*>(arg);
+            std::thread([&race] {
+                PV::PasswordEntry entry;
+                race.seen = race.vault->GetEntryDetail(race.entry_id, entry);
+            }).join();
+            return 0;
+        }, &race);
+        CHECK(vault.DeleteCodebook(codebook));
+        sqlite3_commit_hook(auth.GetDatabaseHandle(), nullptr, nullptr);
+
+        CHECK(race.seen);
+        PV::PasswordEntry entry;
+        CHECK(!vault.GetEntryDetail(entry_id, entry));
+    }
+    RemoveDatabase();
+}
+
+// 同上，针对共享的用户缓存：提交前读到的密码本列表不能留在缓存里
+void TestCodebookListRacingReader() {
+    RemoveDatabase();
+    {
+        UserAuth auth(kPath);
+        sqlite3_exec(auth.GetDatabaseHandle(), "INSERT INTO User VALUES ('alice', 'x')", nullptr, nullptr, nullptr);
+        PV vault(auth.GetDatabase(), auth.GetReadPool());
+        vault.SetUserCache(auth.GetUserCache());
+
+        struct Race {
+            PV* vault;
+            size_t seen = 0;
+        } race{&vault};
+        sqlite3_commit_hook(auth.GetDatabaseHandle(), [](void* arg) {
+            Race& race = *static_cast<Race*>(arg);
+            std::thread([&race] { race.seen = race.vault->GetUserCodebooks("alice").size(); }).join();
+            return 0;
+        }, &race);
+
+        int codebook = static_cast<int>(vault.CreateCodebook("alice", "main").id);
+        CHECK(race.seen == 0);
+        CHECK(vault.GetUserCodebooks("alice").size() == 1);
+
+        CHECK(vault.DeleteCodebook(codebook));
+        CHECK(race.seen == 1);
+        CHECK(vault.GetUserCodebooks("alice").empty());
+        sqlite3_commit_hook(auth.GetDatabaseHandle(), nullptr, nullptr);
+    }
+    RemoveDatabase();
+}
+
+std::vector<std::string> LoginCodebooks(UserAuth& auth) {
+    std::vector<UserAuth::CodebookInfo> codebooks;
+    CHECK(auth.Login("bob", "Correct-Horse-9!", codebooks));
+    std::vector<std::string> names;
+    for (const UserAuth::CodebookInfo& codebook : codebooks) {
+        names.push_back(codebook.name);
+    }
+    return names;
+}
+
+// 未接入 SetUserCache 的 PasswordVault 不会更新缓存，此时 Login 不能返回缓存中的旧列表
+void TestCodebooksWithoutSharedCache() {
+    UserAuth auth(":memory:", StorageProfile(), KdfPolicy::Interactive());
+    CHECK(auth.Register("bob", "Correct-Horse-9!"));
+    CHECK(LoginCodebooks(auth).empty());
+
+    PV vault(auth.GetDatabase(), auth.GetReadPool());
+    int codebook = static_cast<int>(vault.CreateCodebook("bob", "work").id);
+    CHECK((LoginCodebooks(auth) == std::vector<std::string>{"work"}));
+    CHECK(vault.DeleteCodebook(codebook));
+    CHECK(LoginCodebooks(auth).empty());
+}
+
+// 共享缓存时，外层事务回滚的新建/删除不能留在缓存的列表里
+void TestCodebooksRolledBack() {
+    UserAuth auth(":memory:", StorageProfile(), KdfPolicy::Interactive());
+    CHECK(auth.Register("bob", "Correct-Horse-9!"));
+    PV vault(auth.GetDatabase(), auth.GetReadPool());
+    vault.SetUserCache(auth.GetUserCache());
+    int codebook = static_cast<int>(vault.CreateCodebook("bob", "work").id);
+    CHECK((LoginCodebooks(auth) == std::vector<std::string>{"work"}));
+
+    CHECK(auth.GetDatabase().BeginTransaction());
+    vault.CreateCodebook("bob", "phantom");
+    CHECK(vault.DeleteCodebook(codebook));
+    CHECK(auth.GetDatabase().RollbackTransaction());
+    CHECK((LoginCodebooks(auth) == std::vector<std::string>{"work"}));
+
+    CHECK(auth.GetDatabase().BeginTransaction());
+    vault.CreateCodebook("bob", "home");
+    CHECK(auth.GetDatabase().CommitTransaction());
+    CHECK((LoginCodebooks(auth) == std::vector<std::string>{"home", "work"}));
+}
+
+} // namespace
+
+int main() {
+    TestEntryInvalidationAfterCommit();
+    TestDeleteCodebookRacingReader();
+    TestCodebookListRacingReader();
+    TestCodebooksWithoutSharedCache();
+    TestCodebooksRolledBack();
+    return ReportChecks("cache");
+}
\ No newline at end of file
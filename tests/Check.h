@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdio>
+#include <cstdlib>
+
+// 不依赖测试框架的检查宏：失败时打印位置并继续，main 以 ReportChecks 的结果退出。
+// 不用 assert，Release 构建下同样生效
+inline int& CheckFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(cond)                                                                  \
+    do {                                                                             \
+        if (!(cond)) {                                                               \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            ++CheckFailures();                                                       \
+        }                                                                            \
+    } while (0)
+
+inline int ReportChecks(const char* suite) {
+    if (CheckFailures()) {
+        std::fprintf(stderr, "%s: %d check(s) failed\n", suite, CheckFailures());
+        return EXIT_FAILURE;
+    }
+    std::printf("%s tests passed\n", suite);
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
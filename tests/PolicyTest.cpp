@@ -0,0 +1,42 @@
+// 密码校验：Account() 与原先正则一致，只拒绝换行符
+#include <string>
+#include "PassWordGen.h"
+#include "PasswordPolicy.h"
+#include "Check.h"
+
+namespace {
+
+void TestControlCharacters() {
+    const PasswordPolicy policy = PasswordPolicy::Account();
+    CHECK(policy.Check("Passw0rd").ok());
+    CHECK(policy.Check("Pass\tw0rd").ok());
+    CHECK(policy.Check(std::string("Pass\x01w0rd\x7F")).ok());
+    CHECK(policy.Check("Pässw0rd").ok());
+    CHECK(policy.Check("Pass\nw0rd").failures == POLICY_DISALLOWED_CHAR);
+    CHECK(policy.Check("Pass\rw0rd").failures == POLICY_DISALLOWED_CHAR);
+}
+
+void TestDisallowedClasses() {
+    const PasswordPolicy policy = PasswordPolicy::Basic();
+    CHECK(policy.Check("Passw0rd").ok());
+    CHECK(policy.Check("Pass\tw0rd").failures == POLICY_DISALLOWED_CHAR);
+    CHECK(policy.Check("Passw0rd!").failures == POLICY_DISALLOWED_CHAR);
+}
+
+// 自定义策略允许长度 0 与 1，洗牌不能越界
+void TestShortCustomLength() {
+    const PasswordPolicy policy{0, 4, 0, CHAR_ALNUM, 0, false};
+    CHECK(PasswordGenerator(0).generate(policy).empty());
+    const std::string one = PasswordGenerator(1).generate(policy);
+    CHECK(one.size() == 1);
+    CHECK(policy.Check(one).ok());
+}
+
+} // namespace
+
+int main() {
+    TestControlCharacters();
+    TestDisallowedClasses();
+    TestShortCustomLength();
+    return ReportChecks("policy");
+}
\ No newline at end of file
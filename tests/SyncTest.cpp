@@ -0,0 +1,257 @@
+// 两副本（及中转副本）增量同步：冲突裁决、墓碑与收敛
+#include <sqlite3.h>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "PassWordVault.h"
+#include "UserAuth.h"
+#include "Check.h"
+
+namespace {
+
+using PV = PasswordVault;
+
+struct Replica {
+    UserAuth auth{":memory:"};
+    PV vault{auth.GetDatabase()};
+    int codebook = 0;
+
+    Replica() {
+        sqlite3_exec(auth.GetDatabaseHandle(), "INSERT INTO User VALUES ('alice', 'x')", nullptr, nullptr, nullptr);
+        codebook = static_cast<int>(vault.CreateCodebook("alice", "main").id);
+    }
+
+    // 按 address 找本地 entry_id，不存在返回 0
+    int Find(const std::string& address) {
+        int id = 0;
+        vault.ForEachEntry(codebook, [&](const PV::EntryView& entry) {
+            if (entry.address == address) {
+                id = entry.id;
+            }
+            return true;
+        });
+        return id;
+    }
+
+    std::vector<std::string> Dump() {
+        std::vector<std::string> rows;
+        vault.ForEachEntry(codebook, [&](const PV::EntryView& entry) {
+            rows.push_back(std::string(entry.address) + "|" +
+                           std::string(entry.encrypted_password.begin(), entry.encrypted_password.end()));
+            return true;
+        });
+        std::sort(rows.begin(), rows.end());
+        return rows;
+    }
+};
+
+// 单向拉取：from 上 since 之后的全部变更应用到 to
+PV::ApplyStats Pull(Replica& from, Replica& to, int64_t& since) {
+    PV::ApplyStats total{0, 0, 0};
+    PV::ChangeSet changes;
+    do {
+        CHECK(from.vault.GetChangesSince(from.codebook, since, changes, 2));
+        PV::ApplyStats stats{0, 0, 0};
+        WriteResult applied = to.vault.ApplyChanges(to.codebook, changes, &stats);
+        CHECK(applied);
+        if (!applied) {
+            break;
+        }
+        total.applied += stats.applied;
+        total.skipped += stats.skipped;
+        since = changes.revision;
+    } while (changes.more);
+    return total;
+}
+
+struct Link {
+    Replica& a;
+    Replica& b;
+    int64_t a_to_b = 0;
+    int64_t b_to_a = 0;
+
+    void Sync() {
+        Pull(a, b, a_to_b);
+        Pull(b, a, b_to_a);
+        Pull(a, b, a_to_b);
+    }
+};
+
+// updated_time 精确到毫秒，先后两次写入之间留出间隔
+void Tick() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+}
+
+void TestUpdateUpdateConflict() {
+    Replica a, b;
+    Link link{a, b};
+    a.vault.AddEntry(a.codebook, "mail", "pk", "v1");
+    link.Sync();
+
+    CHECK(a.vault.UpdateEntry(a.Find("mail"), "mail", "pk", "from-a", ""));
+    Tick();
+    CHECK(b.vault.UpdateEntry(b.Find("mail"), "mail", "pk", "from-b", ""));
+    link.Sync();
+
+    CHECK(a.Dump() == b.Dump());
+    CHECK(a.Dump() == std::vector<std::string>{"mail|from-b"});
+}
+
+void TestDeleteUpdateConflict() {
+    Replica a, b;
+    Link link{a, b};
+    a.vault.AddEntry(a.codebook, "late-update", "pk", "v1");
+    a.vault.AddEntry(a.codebook, "late-delete", "pk", "v1");
+    link.Sync();
+
+    // 删除在先、修改在后：修改胜出，删除方重新得到条目
+    CHECK(a.vault.DeleteEntry(a.Find("late-update")));
+    Tick();
+    CHECK(b.vault.UpdateEntry(b.Find("late-update"), "late-update", "pk", "v2", ""));
+    // 修改在先、删除在后：删除胜出
+    CHECK(b.vault.UpdateEntry(b.Find("late-delete"), "late-delete", "pk", "v2", ""));
+    Tick();
+    CHECK(a.vault.DeleteEntry(a.Find("late-delete")));
+    link.Sync();
+
+    CHECK(a.Dump() == b.Dump());
+    CHECK(a.Dump() == std::vector<std::string>{"late-update|v2"});
+}
+
+void TestDeleteDeleteConflict() {
+    Replica a, b;
+    Link link{a, b};
+    a.vault.AddEntry(a.codebook, "gone", "pk", "v1");
+    a.vault.AddEntry(a.codebook, "kept", "pk", "v1");
+    link.Sync();
+
+    CHECK(a.vault.DeleteEntry(a.Find("gone")));
+    Tick();
+    CHECK(b.vault.DeleteEntry(b.Find("gone")));
+    link.Sync();
+    // 再次同步不应失败，也不应再有变更
+    link.Sync();
+    CHECK(a.Dump() == b.Dump());
+    CHECK(a.Dump() == std::vector<std::string>{"kept|v1"});
+
+    int64_t since = link.a_to_b;
+    PV::ChangeSet changes;
+    CHECK(a.vault.GetChangesSince(a.codebook, since, changes));
+    CHECK(changes.changes.empty());
+}
+
+void TestTombstoneForUnknownEntry() {
+    Replica a, b, c;
+    PV::ChangeSet changes;
+    changes.revision = 1;
+    changes.more = false;
+    PV::EntryChange change;
+    change.sync_id = std::string(16, '\x5A');
+    change.revision = 1;
+    change.updated_time = "2030-01-01 00:00:00.000";
+    change.deleted = true;
+    changes.changes.push_back(change);
+
+    PV::ApplyStats stats{0, 0, 0};
+    CHECK(a.vault.ApplyChanges(a.codebook, changes, &stats));
+    CHECK(stats.applied == 1);
+    // 重复应用被忽略
+    CHECK(a.vault.ApplyChanges(a.codebook, changes, &stats));
+    CHECK(stats.applied == 0 && stats.skipped == 1);
+
+    // 未见过该条目的副本经 a 中转仍收到删除
+    int64_t since = 0;
+    CHECK(Pull(a, c, since).applied == 1);
+    CHECK(c.vault.GetChangesSince(c.codebook, 0, changes));
+    CHECK(changes.changes.size() == 1 && changes.changes[0].deleted &&
+          changes.changes[0].sync_id == change.sync_id);
+    CHECK(b.Dump().empty());
+}
+
+void TestTieKeepsSourceTime() {
+    Replica a, b;
+    a.vault.AddEntry(a.codebook, "tie", "pk", "aaa");
+    PV::ChangeSet changes;
+    CHECK(a.vault.GetChangesSince(a.codebook, 0, changes));
+
+    // 同一时间、密文较大的远端版本胜出，本地应保留来源的 updated_time
+    PV::EntryChange change = changes.changes.at(0);
+    change.fields.encrypted_password = "zzz";
+    changes.changes = {change};
+    PV::ApplyStats stats{0, 0, 0};
+    CHECK(a.vault.ApplyChanges(a.codebook, changes, &stats));
+    CHECK(stats.applied == 1);
+
+    CHECK(a.vault.GetChangesSince(a.codebook, 0, changes));
+    CHECK(changes.changes.size() == 1);
+    CHECK(changes.changes[0].updated_time == change.updated_time);
+    CHECK(changes.changes[0].fields.encrypted_password == "zzz");
+    CHECK(changes.changes[0].revision > change.revision);
+}
+
+// 文本编码迁移只改存储类型：revision 与 updated_time 不变，不产生新的变更
+void TestStorageRewriteIsNotAChange() {
+    Replica a;
+    std::string sql = "INSERT INTO PasswordEntry (codebook_id, address, public_key, encrypted_password) VALUES (" +
+                      std::to_string(a.codebook) + ", 'legacy', 'pk', '616263')";
+    CHECK(sqlite3_exec(a.auth.GetDatabaseHandle(), sql.c_str(), nullptr, nullptr, nullptr) == SQLITE_OK);
+    PV::ChangeSet before;
+    CHECK(a.vault.GetChangesSince(a.codebook, 0, before));
+    CHECK(before.changes.size() == 1);
+
+    Tick();
+    CHECK(a.vault.MigrateTextEncodedEntries() == 1);
+    PV::ChangeSet changes;
+    CHECK(a.vault.GetChangesSince(a.codebook, before.revision, changes));
+    CHECK(changes.changes.empty());
+    CHECK(a.vault.GetChangesSince(a.codebook, 0, changes));
+    CHECK(changes.changes.size() == 1);
+    CHECK(changes.changes[0].revision == before.changes[0].revision);
+    CHECK(changes.changes[0].updated_time == before.changes[0].updated_time);
+}
+
+// 参与同步的密码本不能开始轮换；轮换进行中的密码本不能导出或应用变更
+void TestSyncExcludesRotation() {
+    Replica a, b, c;
+    a.vault.AddEntry(a.codebook, "mail", "pk", "aaa");
+    Link{a, b}.Sync();
+    const std::vector<uint8_t> header(32, 7);
+    CHECK(a.vault.BeginRotation(a.codebook, header).status == WriteStatus::ConstraintFailed);
+    CHECK(b.vault.BeginRotation(b.codebook, header).status == WriteStatus::ConstraintFailed);
+
+    CHECK(c.vault.BeginRotation(c.codebook, header));
+    PV::ChangeSet changes;
+    bool refused = false;
+    try {
+        c.vault.GetChangesSince(c.codebook, 0, changes);
+    } catch (const std::logic_error&) {
+        refused = true;
+    }
+    CHECK(refused);
+    CHECK(a.vault.GetChangesSince(a.codebook, 0, changes));
+    refused = false;
+    try {
+        c.vault.ApplyChanges(c.codebook, changes);
+    } catch (const std::logic_error&) {
+        refused = true;
+    }
+    CHECK(refused);
+    CHECK(c.Dump().empty());
+}
+
+} // namespace
+
+int main() {
+    TestUpdateUpdateConflict();
+    TestDeleteUpdateConflict();
+    TestDeleteDeleteConflict();
+    TestTombstoneForUnknownEntry();
+    TestTieKeepsSourceTime();
+    TestStorageRewriteIsNotAChange();
+    TestSyncExcludesRotation();
+    return ReportChecks("sync");
+}
\ No newline at end of file